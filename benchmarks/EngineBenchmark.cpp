@@ -0,0 +1,80 @@
+#include "dragon/Engine.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Measures a rule script evaluated once per request, in requests per second:
+// `compile` builds a new program for every request, `reuse` runs one program
+// on one engine with new inputs. Both must print the same.
+//
+//   dragon-enginebench [requests]
+
+static const char *Rules =
+    "function score(amount, country, vip)\n"
+    "  s = 0\n"
+    "  if amount > 1000\n"
+    "    s = s + 40\n"
+    "  endif\n"
+    "  if country == \"unknown\"\n"
+    "    s = s + 25\n"
+    "  endif\n"
+    "  if vip\n"
+    "    s = s - 30\n"
+    "  endif\n"
+    "  return s\n"
+    "limits = dict()\n"
+    "limits[\"low\"] = 20\n"
+    "limits[\"high\"] = 50\n"
+    "s = score(amount, country, vip)\n"
+    "if s >= limits[\"high\"]\n"
+    "  println \"deny \" + country\n"
+    "else\n"
+    "  if s >= limits[\"low\"]\n"
+    "    println \"review\"\n"
+    "  else\n"
+    "    println \"allow\"\n"
+    "  endif\n"
+    "endif\n";
+
+static void setInputs(Engine &E, std::size_t Request) {
+  E.setInt("amount", Request * 37 % 2000);
+  E.setString("country", Request % 3 ? "somewhere far away" : "unknown");
+  E.setBool("vip", Request % 5 == 0);
+}
+
+template <typename F> static double measure(std::size_t Requests, F &&Fn) {
+  auto Start = std::chrono::steady_clock::now();
+  for (std::size_t Request = 0; Request < Requests; ++Request)
+    Fn(Request);
+  std::chrono::duration<double> Time =
+      std::chrono::steady_clock::now() - Start;
+  return Requests / Time.count();
+}
+
+int main(int argc, char **argv) {
+  std::size_t Requests = argc > 1 ? std::atol(argv[1]) : 100000;
+  if (!Requests)
+    Requests = 1;
+  std::size_t Checksum = 0, ReuseChecksum = 0;
+  auto Compiled = measure(Requests, [&](std::size_t Request) {
+    Program P(Rules);
+    Engine E(P);
+    setInputs(E, Request);
+    Checksum += std::hash<std::string>()(E.run()) ^ Request;
+  });
+  Program P(Rules);
+  Engine E(P);
+  auto Reused = measure(Requests, [&](std::size_t Request) {
+    setInputs(E, Request);
+    ReuseChecksum += std::hash<std::string>()(E.run()) ^ Request;
+  });
+  std::cout << "Requests: " << Requests << "\ncompile " <<
+               static_cast<std::size_t>(Compiled) << "/s, reuse " <<
+               static_cast<std::size_t>(Reused) << "/s\n";
+  if (Checksum != ReuseChecksum) {
+    std::cout << "Outputs differ between the two modes\n";
+    return 1;
+  }
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "dragon/analysis/LexicalAnalyzer.h"
+#include "dragon/structures/MappedFile.h"
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+// Measures lexer throughput for every scan level the CPU supports. The
+// `scan` column walks the input with the scanning kernels only, the `lex`
+// column runs the whole lexer, including building the tokens.
+//
+//   dragon-lexbench [file] [runs]
+//
+// Without a file a synthetic script of about 64 MB is lexed.
+
+static std::string generateSource(std::size_t Size) {
+  static const char *Lines[] = {
+    "function update_counter(counter_value, step_size)\n",
+    "    next_value = counter_value + step_size * 2 - (step_size % 3)\n",
+    "    return next_value\n",
+    "\n",
+    "# Accumulate a running total over the generated range of values\n",
+    "running_total = 0\n",
+    "loop_index = 0\n",
+    "while loop_index < 1000000\n",
+    "    running_total = update_counter(running_total, loop_index) / 1.5\n",
+    "    loop_index = loop_index + 1\n",
+    "endwhile\n",
+    "if running_total >= 12345.678 and loop_index != 0\n",
+    "    println \"the running total is large enough to report\"\n",
+    "endif\n"
+  };
+  std::string Source;
+  Source.reserve(Size + 128);
+  while (Source.size() < Size)
+    for (auto *Line : Lines)
+      Source += Line;
+  return Source;
+}
+
+// Splits the source into the same runs the lexer sees, without building
+// tokens. Returns the number of runs so the work can't be optimized away.
+static std::size_t scanSource(std::string_view Source,
+                              const CharScanner &Scanner) {
+  std::size_t Runs = 0;
+  const char *Ptr = Source.data();
+  const char *End = Ptr + Source.size();
+  while (Ptr != End) {
+    const char *LineEnd = Scanner.find(Ptr, End, '\n');
+    while (Ptr != LineEnd) {
+      Ptr = Scanner.skipSpaces(Ptr, LineEnd);
+      if (Ptr == LineEnd)
+        break;
+      ++Runs;
+      if (CharScanner::is(*Ptr, CharScanner::DIGIT))
+        Ptr = Scanner.skipDigits(Ptr + 1, LineEnd);
+      else if (CharScanner::is(*Ptr, CharScanner::WORD))
+        Ptr = Scanner.skipWord(Ptr + 1, LineEnd);
+      else if (*Ptr == '#')
+        Ptr = LineEnd;
+      else if (*Ptr == '"')
+        Ptr = std::min(Scanner.find(Ptr + 1, LineEnd, '"') + 1, LineEnd);
+      else
+        ++Ptr;
+    }
+    Ptr = LineEnd == End ? End : LineEnd + 1;
+  }
+  return Runs;
+}
+
+// Best throughput of Runs calls of Fn over Size bytes, in MB/s.
+template <typename Func>
+static double measure(std::size_t Size, int Runs, Func Fn) {
+  double Best = 0;
+  for (int Run = 0; Run < Runs; ++Run) {
+    auto Start = std::chrono::steady_clock::now();
+    Fn();
+    std::chrono::duration<double> Time =
+        std::chrono::steady_clock::now() - Start;
+    Best = std::max(Best, Size / Time.count() / (1 << 20));
+  }
+  return Best;
+}
+
+int main(int argc, char **argv) {
+  std::string Generated;
+  std::string_view Source;
+  std::unique_ptr<MappedFile> File;
+  if (argc > 1) {
+    File = std::make_unique<MappedFile>(argv[1]);
+    if (!File->isOpen()) {
+      std::cerr << "Failed to open file `" << argv[1] << "`." << std::endl;
+      return -1;
+    }
+    Source = File->getView();
+  } else {
+    Generated = generateSource(64 << 20);
+    Source = Generated;
+  }
+  int Runs = argc > 2 ? std::atoi(argv[2]) : 5;
+  if (Runs <= 0)
+    Runs = 1;
+
+  std::cout << "Input: " << Source.size() / double(1 << 20) << " MB\n";
+  std::size_t Sink = 0;
+  for (auto Level : { ScanLevel::SCALAR, ScanLevel::SSE2, ScanLevel::AVX2 }) {
+    if (!CharScanner::isSupported(Level))
+      continue;
+    CharScanner Scanner(Level);
+    auto Scan = measure(Source.size(), Runs, [&]() {
+      Sink += scanSource(Source, Scanner);
+    });
+    auto Lex = measure(Source.size(), Runs, [&]() {
+      LexicalAnalyzer LA(Source, Level);
+      Sink += LA.getTokenList().size();
+    });
+    std::cout << CharScanner::levelToString(Level) << ": scan " << Scan <<
+                 " MB/s, lex " << Lex << " MB/s\n";
+  }
+  return Sink == 0;
+}
\ No newline at end of file
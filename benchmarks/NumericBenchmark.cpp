@@ -0,0 +1,158 @@
+#include "dragon/analysis/NumericKernels.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Measures the array builtin kernels for every vector level the CPU
+// supports, in millions of elements per second. Every level is first checked
+// against the scalar kernels on short arrays, which covers the tails.
+//
+//   dragon-numbench [elements] [runs]
+
+static bool isClose(double X, double Y) {
+  return std::fabs(X - Y) <= 1e-9 * std::max(1.0, std::fabs(Y));
+}
+
+static bool isClose(const std::vector<double> &X,
+                    const std::vector<double> &Y) {
+  for (std::size_t I = 0; I < X.size(); ++I)
+    if (!isClose(X[I], Y[I]))
+      return false;
+  return true;
+}
+
+// Compares the kernels of K with the scalar ones, returns the name of the
+// first kernel that differs or nullptr.
+static const char *verify(const NumericKernels &K) {
+  NumericKernels Ref(ScanLevel::SCALAR);
+  std::mt19937_64 Gen(42);
+  std::uniform_real_distribution<double> Floats(-100, 100);
+  std::uniform_int_distribution<std::int64_t> Ints(-1000, 1000);
+  for (std::size_t N = 0; N < 40; ++N) {
+    std::vector<double> X(N), Y(N), Out(N), RefOut(N);
+    std::vector<std::int64_t> A(N), B(N), IntOut(N), RefIntOut(N);
+    for (std::size_t I = 0; I < N; ++I) {
+      X[I] = Floats(Gen);
+      Y[I] = Floats(Gen);
+      A[I] = Ints(Gen);
+      B[I] = Ints(Gen);
+    }
+    std::int64_t Sum = 0, RefSum = 0;
+    if (!isClose(K.sum(X.data(), N), Ref.sum(X.data(), N)))
+      return "sum";
+    if (K.sum(A.data(), N, Sum) != Ref.sum(A.data(), N, RefSum) ||
+        Sum != RefSum)
+      return "sum (int)";
+    if (N && (K.min(X.data(), N) != Ref.min(X.data(), N) ||
+              K.max(X.data(), N) != Ref.max(X.data(), N)))
+      return "min/max";
+    if (N && (K.min(A.data(), N) != Ref.min(A.data(), N) ||
+              K.max(A.data(), N) != Ref.max(A.data(), N)))
+      return "min/max (int)";
+    if (!isClose(K.dot(X.data(), Y.data(), N), Ref.dot(X.data(), Y.data(), N)))
+      return "dot";
+    Out = Y;
+    RefOut = Y;
+    K.axpy(1.5, X.data(), Out.data(), N);
+    Ref.axpy(1.5, X.data(), RefOut.data(), N);
+    if (!isClose(Out, RefOut))
+      return "axpy";
+    K.add(X.data(), Y.data(), Out.data(), N);
+    Ref.add(X.data(), Y.data(), RefOut.data(), N);
+    if (!isClose(Out, RefOut))
+      return "add";
+    K.add(A.data(), B.data(), IntOut.data(), N);
+    Ref.add(A.data(), B.data(), RefIntOut.data(), N);
+    if (IntOut != RefIntOut)
+      return "add (int)";
+    K.mul(X.data(), Y.data(), Out.data(), N);
+    Ref.mul(X.data(), Y.data(), RefOut.data(), N);
+    if (!isClose(Out, RefOut))
+      return "mul";
+    K.prefixSum(X.data(), Out.data(), N);
+    Ref.prefixSum(X.data(), RefOut.data(), N);
+    if (!isClose(Out, RefOut))
+      return "prefix_sum";
+    // An int sum may fail even if it fits, as long as the caller gets no
+    // wrong result.
+    if (N >= 2) {
+      A[0] = A[1] = INT64_MAX;
+      __int128 Exact = 0;
+      for (auto Elem : A)
+        Exact += Elem;
+      if (K.sum(A.data(), N, Sum) && (Exact > INT64_MAX || Sum != Exact))
+        return "sum (int overflow)";
+      B[N - 1] = INT64_MIN;
+      A[N - 1] = -1;
+      if (K.add(A.data(), B.data(), IntOut.data(), N))
+        return "add (int overflow)";
+    }
+  }
+  return nullptr;
+}
+
+// Best throughput of Runs calls of Fn over N elements, in millions per
+// second.
+template <typename Func>
+static double measure(std::size_t N, int Runs, Func Fn) {
+  double Best = 0;
+  for (int Run = 0; Run < Runs; ++Run) {
+    auto Start = std::chrono::steady_clock::now();
+    Fn();
+    std::chrono::duration<double> Time =
+        std::chrono::steady_clock::now() - Start;
+    Best = std::max(Best, N / Time.count() / 1e6);
+  }
+  return Best;
+}
+
+int main(int argc, char **argv) {
+  std::size_t N = argc > 1 ? std::atol(argv[1]) : 1 << 20;
+  int Runs = argc > 2 ? std::atoi(argv[2]) : 20;
+  if (Runs <= 0)
+    Runs = 1;
+  std::vector<double> X(N, 1.25), Y(N, 0.5), Out(N);
+  std::vector<std::int64_t> A(N, 3), B(N, -2), IntOut(N);
+
+  std::cout << "Elements: " << N << "\n";
+  double Sink = 0;
+  int Failed = 0;
+  for (auto Level : { ScanLevel::SCALAR, ScanLevel::SSE2, ScanLevel::AVX2 }) {
+    if (!CharScanner::isSupported(Level))
+      continue;
+    NumericKernels K(Level);
+    if (auto Kernel = verify(K)) {
+      std::cout << CharScanner::levelToString(Level) << ": `" << Kernel <<
+                   "` differs from the scalar kernel\n";
+      ++Failed;
+      continue;
+    }
+    std::int64_t Int;
+    std::cout << CharScanner::levelToString(Level) <<
+        ": sum " << measure(N, Runs, [&]() { Sink += K.sum(X.data(), N); }) <<
+        ", sum (int) " << measure(N, Runs, [&]() {
+          Sink += K.sum(A.data(), N, Int) ? Int : 0;
+        }) <<
+        ", max " << measure(N, Runs, [&]() { Sink += K.max(X.data(), N); }) <<
+        ", dot " << measure(N, Runs, [&]() {
+          Sink += K.dot(X.data(), Y.data(), N);
+        }) <<
+        ", axpy " << measure(N, Runs, [&]() {
+          K.axpy(1e-9, X.data(), Out.data(), N);
+        }) <<
+        ", add " << measure(N, Runs, [&]() {
+          K.add(X.data(), Y.data(), Out.data(), N);
+        }) <<
+        ", add (int) " << measure(N, Runs, [&]() {
+          Sink += K.add(A.data(), B.data(), IntOut.data(), N);
+        }) <<
+        ", prefix_sum " << measure(N, Runs, [&]() {
+          K.prefixSum(X.data(), Out.data(), N);
+        }) << " M/s\n";
+  }
+  return Failed || Sink == 0;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef __DRAGON_ENGINE__
+#define __DRAGON_ENGINE__
+
+#include "dragon/analysis/Interpreter.h"
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Interface for embedding the language: a script is compiled once into a
+// Program, which any number of Engines then run as often as needed.
+//
+//   Program P(Source);
+//   Engine E(P);
+//   E.setInt("limit", 10);
+//   auto &Output = E.run();
+
+// Compiled form of a script. Running it never changes it, so engines on
+// different threads may share one program. The source is not needed once
+// the program is built.
+class Program {
+public:
+  // Throws the errors of the analyzers and the compiler.
+  explicit Program(std::string_view Source,
+                   unsigned OptLevel=Compiler::DefaultOptLevel);
+  const Compiler::FuncList &getFuncList() const { return mFuncs; }
+  // Slot of the global variable with the name, if the script has one.
+  std::optional<std::uint32_t> findGlobal(std::string_view Name) const;
+private:
+  Compiler::FuncList mFuncs;
+};
+
+// Runs a program with inputs and collects what it prints. An engine is
+// meant to be reused: its interpreter keeps the code quickened by earlier
+// runs and its memory, while the globals start over on every run.
+class Engine {
+public:
+  explicit Engine(const Program &P,
+                  std::size_t MaxCallDepth=Interpreter::DefaultMaxCallDepth);
+  Engine(const Engine &) = delete;
+  Engine &operator=(const Engine &) = delete;
+  ~Engine();
+
+  // Inputs are global variables set before every run, until they are
+  // cleared. A name the script never uses as a global is ignored.
+  void setInt(std::string_view Name, std::int64_t Int) {
+    setInput(Name, Value(Int));
+  }
+  void setFloat(std::string_view Name, double Float) {
+    setInput(Name, Value(Float));
+  }
+  void setBool(std::string_view Name, bool Bool) {
+    setInput(Name, Value(Bool));
+  }
+  void setString(std::string_view Name, std::string_view Str);
+  void clearInputs();
+
+  // Returns the output of the run. Errors are thrown, the output printed
+  // before one is still available from getOutput().
+  const std::string &run();
+  const std::string &getOutput() const { return mOutput; }
+private:
+  const Program &mProgram;
+  std::ostringstream mStream;
+  OutputBuffer mOut;
+  Interpreter mInterpreter;
+  // Each input holds a reference to its string, if it has one.
+  Interpreter::GlobalList mInputs;
+  std::string mOutput;
+
+  void setInput(std::string_view Name, const Value &Val);
+  void takeOutput();
+};
+
+#endif
\ No newline at end of file
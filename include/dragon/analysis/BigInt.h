@@ -0,0 +1,58 @@
+#ifndef __DRAGON_BIG_INT__
+#define __DRAGON_BIG_INT__
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Arbitrary-precision integer for results that don't fit in 64 bits. The
+// magnitude is kept in 32-bit limbs, least significant first, without
+// leading zeros; zero has no limbs and is never negative.
+class BigInt {
+public:
+  BigInt() = default;
+  BigInt(std::int64_t Int);
+
+  bool isNegative() const { return mNegative; }
+  bool isZero() const { return mLimbs.empty(); }
+  std::optional<std::int64_t> toInt64() const;
+  double toDouble() const;
+  std::string toString() const;
+  // Negative, zero or positive as this is less than, equal to or greater
+  // than Other.
+  int compare(const BigInt &Other) const;
+
+  BigInt operator-() const;
+  BigInt operator+(const BigInt &Other) const;
+  BigInt operator-(const BigInt &Other) const;
+  BigInt operator*(const BigInt &Other) const;
+  // Remainder of the division truncated toward zero, as for int64. Other
+  // must not be zero.
+  BigInt operator%(const BigInt &Other) const;
+  // Bitwise operators act on the infinite two's complement form.
+  BigInt operator&(const BigInt &Other) const;
+  BigInt operator|(const BigInt &Other) const;
+  BigInt operator^(const BigInt &Other) const;
+  BigInt shl(std::uint64_t Count) const;
+  // Rounds toward negative infinity, as an arithmetic shift.
+  BigInt shr(std::uint64_t Count) const;
+
+  // Flat form kept in a StringObject: the sign byte followed by the limbs.
+  std::size_t getByteSize() const { return 1 + mLimbs.size() * 4; }
+  void writeBytes(char *Out) const;
+  static BigInt readBytes(std::string_view Bytes);
+private:
+  typedef std::vector<std::uint32_t> LimbList;
+  enum class BitOp { AND, OR, XOR };
+  bool mNegative = false;
+  LimbList mLimbs;
+
+  BigInt(bool Negative, LimbList &&Limbs);
+  BigInt bitwise(const BigInt &Other, BitOp Op) const;
+  LimbList toTwosComplement(std::size_t Size) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef __DRAGON_BUILTINS__
+#define __DRAGON_BUILTINS__
+
+#include "dragon/analysis/Token.h"
+#include "dragon/analysis/Value.h"
+#include <optional>
+#include <string_view>
+
+class Interpreter;
+
+// Function implemented by the interpreter itself. It is called like a user
+// function, but a user function of the same name hides it. The arguments are
+// the top ParamCount values of the operand stack, the first one deepest, and
+// the result replaces them.
+struct Builtin {
+  typedef Value (*CallFn)(Interpreter &I, const Value *Args,
+                          const PosInfo &PI);
+  std::string_view Name;
+  std::size_t ParamCount;
+  CallFn Call;
+};
+
+std::size_t getBuiltinCount();
+const Builtin &getBuiltin(std::size_t Idx);
+std::optional<std::size_t> findBuiltin(std::string_view Name);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+#ifndef __DRAGON_BYTECODE__
+#define __DRAGON_BYTECODE__
+
+#include "dragon/analysis/Token.h"
+#include "dragon/analysis/Value.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class Opcode : std::uint8_t {
+  PUSH_CONST,   // push constant A
+  LOAD,         // push local slot A
+  STORE,        // assign top of stack to local slot A, keep the value
+  LOAD_GLOBAL,  // push global slot A
+  STORE_GLOBAL, // assign top of stack to global slot A, keep the value
+  POP,
+  GLOBAL,       // check that global slot A is defined
+  CALL,         // call function A, push result if B != 0
+  TAIL_CALL,    // replace the current frame with a call of function A
+  CALL_NATIVE,  // call builtin A, its result replaces the arguments
+  RET,          // return top of stack
+  RET_VOID,
+  JMP,          // jump to A
+  JMP_IF,       // pop a boolean, jump to A if it is true
+  JMP_IF_FALSE, // pop a boolean, jump to A if it is false
+  MAKE_ARRAY,   // replace the top A values with an array of them
+  LOAD_INDEX,   // `array[index]`
+  STORE_INDEX,  // `value array index`: assign the element, keep the value
+  DELETE_INDEX, // `dict key`: remove the key from the dict
+  SLICE,        // `array low high`: copy of the elements in [low, high)
+  FOR_PREP,     // pop an array or a dict into slot A, its position into A+1
+  FOR_NEXT,     // push the next element or key of slot B, jump to A if none
+
+  /* fused instructions, followed by the instructions they replace */
+  INC_LOCAL,          // `x = x + c`: local slot A, constant B
+  CMP_JMP_LOCAL,      // compare local slots A and B, then jump
+  CMP_JMP_CONST,      // compare local slot A and constant B, then jump
+  BINARY_LOCAL,       // `x = a op b`: local slots A and B
+  BINARY_CONST,       // `x = a op c`: local slot A, constant B
+  INDEX_LOCAL,        // `a[i]`: local slots A and B
+  STORE_INDEX_LOCAL,  // `a[i] = value`: local slots A and B
+
+  /* unary operators */
+  POS,
+  NEG,
+  NOT,
+  LEN,
+  PRINT,        // print top of stack, keep the value
+  PRINTLN,
+
+  /* binary operators */
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  MOD,
+  SHL,
+  SHR,
+  BIT_AND,
+  BIT_OR,
+  BIT_XOR,
+  AND,
+  OR,
+  EQ,
+  NE,
+  LT,
+  LE,
+  GT,
+  GE,
+  IN,           // whether the dict on the right has the key on the left
+
+  /* quickened binary operators, installed by the interpreter at runtime */
+  ADD_INT,
+  SUB_INT,
+  MUL_INT,
+  MOD_INT,
+  EQ_INT,
+  NE_INT,
+  LT_INT,
+  LE_INT,
+  GT_INT,
+  GE_INT,
+  ADD_FLOAT,    // float variants also accept one integer operand
+  SUB_FLOAT,
+  MUL_FLOAT,
+  DIV_FLOAT,
+  LT_FLOAT,
+  LE_FLOAT,
+  GT_FLOAT,
+  GE_FLOAT
+};
+
+// Must name the last opcode, it bounds the opcodes accepted from a compiled
+// program cache.
+constexpr Opcode LastOpcode = Opcode::GE_FLOAT;
+
+// A fused instruction takes its fast path only for operands it handles
+// directly and then skips the original instructions placed after it.
+// Otherwise execution falls through to them, which keeps error reporting
+// exact. The original sequence also supplies the operator, the assigned slot
+// and the jump target.
+constexpr std::size_t getFusedLength(Opcode Op) {
+  switch (Op) {
+  case Opcode::INC_LOCAL: return 5;
+  case Opcode::CMP_JMP_LOCAL:
+  case Opcode::CMP_JMP_CONST: return 4;
+  case Opcode::BINARY_LOCAL:
+  case Opcode::BINARY_CONST: return 5;
+  case Opcode::INDEX_LOCAL:
+  case Opcode::STORE_INDEX_LOCAL: return 3;
+  default: return 0;
+  }
+}
+
+// Specialized form of a generic binary operator for the given operand types,
+// if there is one.
+std::optional<Opcode> getQuickenedOpcode(Opcode Op, Value::Type Left,
+                                         Value::Type Right);
+// Generic form of a quickened operator, other opcodes are returned as is.
+Opcode getGenericOpcode(Opcode Op);
+
+struct Instruction {
+  Opcode Op;
+  std::uint32_t A;
+  std::uint32_t B;
+};
+
+class CompiledFunction {
+public:
+  typedef std::vector<Instruction> CodeList;
+  CompiledFunction(const std::string &Name) : mName(Name) {}
+  const std::string &getName() const { return mName; }
+  void addParam(std::string_view Name) {
+    assert(mLocals.size() == mParamCount &&
+           "Parameters must occupy the first slots!");
+    addLocal(Name);
+    ++mParamCount;
+  }
+  std::size_t getParamCount() const { return mParamCount; }
+  std::uint32_t addLocal(std::string_view Name) {
+    mLocals.emplace_back(Name);
+    return mLocals.size() - 1;
+  }
+  const std::string &getLocalName(std::uint32_t Slot) const {
+    return mLocals[Slot];
+  }
+  std::size_t getFrameSize() const { return mLocals.size(); }
+
+  std::size_t emit(Opcode Op, const PosInfo &PI, std::uint32_t A=0,
+                   std::uint32_t B=0) {
+    mCode.push_back({ Op, A, B });
+    mPositions.push_back(PI);
+    return mCode.size() - 1;
+  }
+  std::uint32_t addConstant(const Constant *Const);
+  std::uint32_t addConstant(const Value &Val);
+  // Copies the string into the pool, so the constant outlives its source.
+  // Equal long strings are interned into one constant that is never
+  // counted, so variables can refer to it without a copy.
+  std::uint32_t addString(std::string_view Str);
+
+  CodeList &getCode() { return mCode; }
+  const CodeList &getCode() const { return mCode; }
+  const PosInfo &getPosInfo(std::size_t PC) const { return mPositions[PC]; }
+  void setCode(CodeList &&Code, std::vector<PosInfo> &&Positions) {
+    assert(Code.size() == Positions.size() && "Every instruction needs a "
+           "position!");
+    mCode = std::move(Code);
+    mPositions = std::move(Positions);
+  }
+  const Value &getConstant(std::uint32_t Idx) const {
+    return mConstants[Idx];
+  }
+  std::size_t getConstantCount() const { return mConstants.size(); }
+  void dump() const;
+private:
+  std::string mName;
+  std::size_t mParamCount = 0;
+  std::vector<std::string> mLocals;
+  CodeList mCode;
+  std::vector<PosInfo> mPositions;
+  std::vector<Value> mConstants;
+  std::vector<std::unique_ptr<char[]>> mStrings;
+  // Long strings of the pool by contents.
+  std::unordered_map<std::string_view, std::uint32_t> mStringIndex;
+};
+
+const char *opcodeToString(Opcode Op);
+
+#endif
\ No newline at end of file
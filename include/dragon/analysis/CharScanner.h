@@ -0,0 +1,54 @@
+#ifndef __DRAGON_CHAR_SCANNER__
+#define __DRAGON_CHAR_SCANNER__
+
+#include <array>
+#include <cstdint>
+
+// Vector width used by the lexer to classify characters.
+enum class ScanLevel { SCALAR, SSE2, AVX2 };
+
+// Scanning kernels of one level. Every kernel returns the first position in
+// [Ptr, End) that doesn't belong to the run, or End.
+class CharScanner {
+public:
+  enum CharClass : std::uint8_t {
+    SPACE = 1 << 0,
+    DIGIT = 1 << 1,
+    WORD = 1 << 2   // letters, digits and '_'
+  };
+
+  CharScanner(ScanLevel Level=getBestLevel());
+  ScanLevel getLevel() const { return mLevel; }
+
+  const char *skipSpaces(const char *Ptr, const char *End) const {
+    return mSkipSpaces(Ptr, End);
+  }
+  const char *skipWord(const char *Ptr, const char *End) const {
+    return mSkipWord(Ptr, End);
+  }
+  const char *skipDigits(const char *Ptr, const char *End) const {
+    return mSkipDigits(Ptr, End);
+  }
+  // Position of the first Char, or End.
+  const char *find(const char *Ptr, const char *End, char Char) const {
+    return mFind(Ptr, End, Char);
+  }
+
+  static bool is(char Char, CharClass Class) {
+    return mClasses[static_cast<unsigned char>(Char)] & Class;
+  }
+  static ScanLevel getBestLevel();
+  static bool isSupported(ScanLevel Level);
+  static const char *levelToString(ScanLevel Level);
+private:
+  typedef const char *(*SkipFn)(const char *, const char *);
+  typedef const char *(*FindFn)(const char *, const char *, char);
+  static const std::array<std::uint8_t, 256> mClasses;
+  ScanLevel mLevel;
+  SkipFn mSkipSpaces;
+  SkipFn mSkipWord;
+  SkipFn mSkipDigits;
+  FindFn mFind;
+};
+
+#endif
\ No newline at end of file
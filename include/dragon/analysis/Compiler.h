@@ -0,0 +1,37 @@
+#ifndef __DRAGON_COMPILER__
+#define __DRAGON_COMPILER__
+
+#include "dragon/analysis/Bytecode.h"
+#include "dragon/analysis/SyntaxAnalyzer.h"
+#include <map>
+
+class Compiler {
+public:
+  typedef std::vector<CompiledFunction> FuncList;
+  static constexpr unsigned DefaultOptLevel = 1;
+  // Functions the analyzer has already generated are compiled right away,
+  // the others on demand with compile().
+  Compiler(SyntaxAnalyzer &SA, unsigned OptLevel=DefaultOptLevel);
+  const FuncList &getFuncList() const { return mFuncs; }
+  // Hands the functions over to a program that outlives the compiler, which
+  // can't compile anything afterwards.
+  FuncList takeFuncList() { return std::move(mFuncs); }
+  bool isCompiled(std::size_t Idx) const {
+    return !mFuncs[Idx].getCode().empty();
+  }
+  void compile(std::size_t Idx);
+  std::optional<std::size_t> findFunction(const std::string &Name) const {
+    return mSA.findFunction(Name);
+  }
+  void dump() const;
+private:
+  void compileFunction(const Function &F, CompiledFunction &CF);
+  std::uint32_t getGlobalSlot(std::string_view Name);
+  SyntaxAnalyzer &mSA;
+  unsigned mOptLevel;
+  FuncList mFuncs;
+  CompiledFunction *mGlobalFunc;
+  std::map<std::string, std::uint32_t, std::less<>> mGlobalSlots;
+};
+
+#endif
\ No newline at end of file
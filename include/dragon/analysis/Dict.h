@@ -0,0 +1,72 @@
+#ifndef __DRAGON_DICT__
+#define __DRAGON_DICT__
+
+#include "dragon/analysis/Value.h"
+#include <cstdint>
+#include <vector>
+
+// Hash table of a dict value, from ints and strings to any values. Entries
+// are kept in insertion order in a dense array, which iteration walks. An
+// open-addressing index with linear probing maps hashes to the entries; an
+// erased key shifts the following slots back, so the index never holds
+// tombstones. Every entry keeps the full hash of its key: growing never
+// hashes a key again, and probing compares keys only when hashes match.
+//
+// A dict owns a reference to every object among its keys and values. It is
+// counted like any other heap object, so a dict that contains itself is
+// never freed.
+class Dict {
+public:
+  struct Entry {
+    std::uint64_t Hash;
+    Value Key;   // nil once the entry is erased
+    Value Val;
+  };
+
+  Dict() = default;
+  Dict(const Dict &) = delete;
+  Dict &operator=(const Dict &) = delete;
+  ~Dict();
+
+  static bool isKey(const Value &Key) {
+    return Key.isInt() || Key.isString();
+  }
+  static std::uint64_t hash(const Value &Key);
+
+  std::size_t size() const { return mSize; }
+  // Value of the key, or nullptr if it is missing.
+  Value *find(const Value &Key, std::uint64_t Hash);
+  // Key must be missing. The dict takes over the references held by Key and
+  // Val.
+  void insert(const Value &Key, const Value &Val, std::uint64_t Hash);
+  // Drops the references of the key and its value. Returns false if the key
+  // is missing.
+  bool erase(const Value &Key, std::uint64_t Hash);
+
+  // Entries in insertion order, erased ones included. Only an insertion
+  // moves them, when it compacts the array.
+  std::size_t getEntryCount() const { return mEntries.size(); }
+  const Entry &getEntry(std::size_t Idx) const { return mEntries[Idx]; }
+
+  // Places an empty dict into a new heap object with one reference.
+  static const StringObject *create();
+private:
+  // Low half of the hash, which rules out most keys without loading their
+  // entry, and the position of the entry plus one, 0 for an empty slot.
+  struct Slot {
+    std::uint32_t Hash;
+    std::uint32_t Entry;
+  };
+  std::vector<Slot> mIndex;
+  std::vector<Entry> mEntries;
+  std::size_t mSize = 0;
+
+  std::size_t getMask() const { return mIndex.size() - 1; }
+  // Slot of the key in the index, or the index size if it is missing.
+  std::size_t findSlot(const Value &Key, std::uint64_t Hash) const;
+  void place(std::uint64_t Hash, std::size_t Pos);
+  // Drops erased entries and rebuilds the index with room for one more.
+  void rebuild();
+};
+
+#endif
\ No newline at end of file
@@ -1,44 +1,115 @@
 #ifndef __DRAGON_INTERPRETER__
 #define __DRAGON_INTERPRETER__
 
-#include "dragon/analysis/SyntaxAnalyzer.h"
-#include <map>
-#include <set>
-#include <stack>
+#include "dragon/analysis/Compiler.h"
+#include "dragon/analysis/Operations.h"
+#include "dragon/structures/OutputBuffer.h"
+#include "dragon/structures/Random.h"
 #include <deque>
 
-class InterpreterException : public std::exception {
-public:
-  InterpreterException(const std::string &Msg) {
-    mMsg = "[RUNTIME EXCEPTION] " + Msg + ".\n";
-  }
-  virtual const char *what() const noexcept { return mMsg.c_str(); }
-private:
-  std::string mMsg;
-};
-
 class Interpreter {
 public:
-  Interpreter(const SyntaxAnalyzer &SA);
+  static constexpr std::size_t DefaultMaxCallDepth = 100000;
+  typedef Compiler::FuncList FuncList;
+  // Global slots and their values at the start of a run.
+  typedef std::vector<std::pair<std::uint32_t, Value>> GlobalList;
+  // Functions that aren't compiled yet are compiled by C on their first
+  // call.
+  Interpreter(Compiler &C, OutputBuffer &Out,
+              std::size_t MaxCallDepth=DefaultMaxCallDepth);
+  // For a program whose functions are all compiled, e.g. loaded from a
+  // cache. The functions are only read, interpreters on other threads may
+  // share them.
+  Interpreter(const FuncList &Funcs, OutputBuffer &Out,
+              std::size_t MaxCallDepth=DefaultMaxCallDepth);
   ~Interpreter();
+
+  // Runs the global code, then `main` if there is one. Every run starts
+  // from nil globals but for the given ones, even after a run that failed.
+  // Code quickened by earlier runs is kept.
+  void run(const GlobalList &Globals={});
+
+  // Services for the builtins. Their results live until the end of the
+  // statement that calls them, unless a variable takes them.
+  Value createArray(Value::Type ElementType, std::size_t Length,
+                    const PosInfo &PI);
+  Value createDict();
+  // Pushes a value kept elsewhere, e.g. in a dict, which the statement holds
+  // on to from then on.
+  Value load(const Value &Var);
+  Arena &getArena() { return mArena; }
+  // Every run starts from the same seed, until the program sets another.
+  Random &getRandom() { return mRandom; }
 private:
-  typedef SyntaxAnalyzer::FuncMap FuncMap;
-  typedef std::map<std::string, Constant *> VarTable;
-  typedef std::pair<VarTable::iterator, VarTable *> VarTableItrPair;
-  const FuncMap &mFM;
-  std::stack<Constant *> mCallStack;
-  std::deque<std::set<Token *>> mTmpTokens; 
-  std::deque<VarTable> mVarTableStack;
-  std::deque<std::set<std::string>> mGlobVarSetStack;
-  std::stack<const Function *> mFuncStack;
+  // Start of the temporaries of a frame: strings in the arena and
+  // references held by the operand stack.
+  struct TempMark {
+    Arena::Mark Strings;
+    std::size_t Refs;
+  };
+  // Activation record of a running function. Its slots start at Base in
+  // mSlots; PC holds the return address while a callee is running.
+  struct Frame {
+    const CompiledFunction *Func;
+    Instruction *Code;
+    std::size_t Base;
+    std::size_t PC;
+    TempMark Mark;
+    // Frames replaced by tail calls on the way to this one.
+    std::size_t TailCalls = 0;
+  };
+  Interpreter(const FuncList &Funcs, Compiler *C, OutputBuffer &Out,
+              std::size_t MaxCallDepth);
+  Compiler *mCompiler;
+  OutputBuffer &mOut;
+  const FuncList &mFuncs;
+  const CompiledFunction &mGlobalFunc;
+  // Private copy of the code of every function, binary operator sites are
+  // rewritten in place once they have seen enough operands of one type.
+  std::vector<CompiledFunction::CodeList> mCode;
+  // Variable slots of all active frames, globals at the bottom. The storage
+  // only grows, so frames are reused across calls.
+  std::vector<Value> mSlots;
+  std::vector<Frame> mFrames;
+  std::size_t mMaxCallDepth;
+  // Sum of TailCalls over mFrames, counted in the call depth.
+  std::size_t mTailCalls = 0;
+  std::vector<Value> mStack;
+  // Scratch memory for strings produced while evaluating a statement.
+  Arena mArena;
+  // Shared strings loaded onto the operand stack. Each holds a reference
+  // until the statement ends, so the string survives a reassignment of its
+  // variable in the meantime.
+  std::vector<const StringObject *> mTempRefs;
+  // Temporaries before the first run, nothing is held there.
+  TempMark mStartMark;
+  Random mRandom;
 
-  bool callFunction(const std::string &FName);
-  void processUnary(const PrefixOperator *Op, Token *Top);
-  void processAssign(Token *OpLeft, Token *OpRight);
-  Token *processBinary(const BinaryOperator *Op, Token *OpLeft, Token *OpRight);
-  void processBinaryGoto(Token *OpLeft, Token *OpRight, std::size_t &Idx);
-  VarTableItrPair getVarItr(const Identifier *Id, bool Exception=true);
-  bool run(const Function &F);
+  std::optional<std::size_t> findFunction(std::string_view Name) const;
+  void compileFunction(std::size_t FuncIdx);
+  void pushFrame(std::size_t FuncIdx, const PosInfo &PI);
+  void popFrame();
+  void processPrint(const Value &Top, bool NewLine, const PosInfo &PI);
+  Value makeOwned(const Value &Val);
+  void releaseOwned(Value &Val);
+  Value appendString(const Value &Left, std::string_view Right,
+                     const PosInfo &PI);
+  void makeArray(std::size_t Count, const PosInfo &PI);
+  void storeKey(Dict &D, const Value &Key, const Value &Val,
+                const PosInfo &PI);
+  Value sliceArray(const Value &Array, const Value &Low, const Value &High,
+                   const PosInfo &PI);
+  Value processArray(Opcode Op, const Value &Left, const Value &Right,
+                     const PosInfo &PI);
+  TempMark markTemps() const { return { mArena.mark(), mTempRefs.size() }; }
+  void releaseTemps(const TempMark &Mark) {
+    mArena.release(Mark.Strings);
+    if (mTempRefs.size() > Mark.Refs)
+      releaseTempRefs(Mark.Refs);
+  }
+  void releaseTempRefs(std::size_t Count);
+  void reset();
+  void execute(std::size_t FuncIdx, const PosInfo &PI);
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef __DRAGON_LEXICAL_ANALYZER__
 #define __DRAGON_LEXICAL_ANALYZER__
 
+#include "dragon/analysis/CharScanner.h"
 #include "dragon/analysis/Token.h"
 #include <iostream>
 #include <istream>
@@ -8,60 +9,7 @@
 #include <memory>
 #include <optional>
 #include <exception>
-
-class CharBuffer {
-public:
-  struct ConstIterator {
-    using iterator_category = std::forward_iterator_tag;
-    using difference_type = std::ptrdiff_t;
-    using value_type = char;
-    using pointer = const char*;
-    using reference = const char&;
-    
-    ConstIterator(pointer Ptr) : mPtr(Ptr) {}
-
-    const reference operator*() const { return *mPtr; }
-    
-    pointer operator->() { return mPtr; }
-    
-    ConstIterator operator++() { mPtr++; return *this; }
-    
-    ConstIterator operator++(int) {
-      ConstIterator Tmp = *this;
-      ++(*this);
-      return Tmp;
-    }
-
-    friend bool operator==(const ConstIterator &LHS, const ConstIterator &RHS) {
-      return LHS.mPtr == RHS.mPtr;
-    }
-
-    friend bool operator!=(const ConstIterator &LHS, const ConstIterator &RHS) {
-      return LHS.mPtr != RHS.mPtr;
-    }
-
-    pointer getPtr() const { return mPtr; }
-
-  private:
-    pointer mPtr;
-  };
-  CharBuffer(const std::string &String) : mString(String) {}
-  
-  ConstIterator begin() { return ConstIterator(&mString[0]); }
-  ConstIterator end() { return ConstIterator(&mString[mString.length()]); }
-
-  ConstIterator cbegin() const { return ConstIterator(&mString[0]); }
-  ConstIterator cend() const { return ConstIterator(&mString[mString.length()]);}
-
-  std::optional<char> lookAhead(const ConstIterator &Itr) const {
-    if (Itr == cend() || std::next(Itr) == cend())
-      return std::nullopt;
-    return *std::next(Itr);
-  };
-
-private:
-  const std::string &mString;
-};
+#include <string_view>
 
 class ParserException : public std::exception {
 public:
@@ -76,13 +24,22 @@ private:
 class LexicalAnalyzer {
 public:
   typedef std::vector<std::vector<std::unique_ptr<Token>>> TokenList;
-  LexicalAnalyzer(std::istream &IS);
+  // Reads the whole stream into an internal buffer and lexes it.
+  LexicalAnalyzer(std::istream &IS,
+                  ScanLevel Level=CharScanner::getBestLevel());
+  // Lexes the source in place, e.g. a mapped file. Identifier and literal
+  // tokens refer to it, so it must outlive the analyzer and its tokens.
+  LexicalAnalyzer(std::string_view Source,
+                  ScanLevel Level=CharScanner::getBestLevel());
   const TokenList &getTokenList() const { return mTokens; }
   void dump() const;
 private:
-  void parseLine(const std::string &Line);
+  void parseSource(std::string_view Source);
+  void parseLine(std::string_view Line);
+  CharScanner mScanner;
+  std::string mBuffer;
   TokenList mTokens;
-  int mLineN;
+  int mLineN = 0;
 };
 
 #endif
\ No newline at end of file
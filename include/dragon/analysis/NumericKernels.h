@@ -0,0 +1,102 @@
+#ifndef __DRAGON_NUMERIC_KERNELS__
+#define __DRAGON_NUMERIC_KERNELS__
+
+#include "dragon/analysis/CharScanner.h"
+#include <cstddef>
+#include <cstdint>
+
+// Kernels over contiguous numbers of one vector level, used by the array
+// builtins. Float reductions add in lane order, so their rounding may differ
+// between levels. Int kernels that can overflow return false when they do,
+// the output is unspecified then.
+//
+// Int kernels that multiply have no vector form before AVX-512 and int
+// minimum and maximum need SSE4.2, they run the scalar code on the lower
+// levels.
+class NumericKernels {
+public:
+  NumericKernels(ScanLevel Level=getBestLevel());
+  ScanLevel getLevel() const { return mLevel; }
+
+  // Fills with a bit pattern, which serves ints and floats alike.
+  void fill(std::uint64_t *Data, std::size_t N, std::uint64_t Bits) const {
+    mFill(Data, N, Bits);
+  }
+  double sum(const double *X, std::size_t N) const { return mSum(X, N); }
+  bool sum(const std::int64_t *X, std::size_t N, std::int64_t &Res) const {
+    return mSumInt(X, N, Res);
+  }
+  // N must not be 0.
+  double min(const double *X, std::size_t N) const { return mMin(X, N); }
+  double max(const double *X, std::size_t N) const { return mMax(X, N); }
+  std::int64_t min(const std::int64_t *X, std::size_t N) const {
+    return mMinInt(X, N);
+  }
+  std::int64_t max(const std::int64_t *X, std::size_t N) const {
+    return mMaxInt(X, N);
+  }
+  double dot(const double *X, const double *Y, std::size_t N) const {
+    return mDot(X, Y, N);
+  }
+  bool dot(const std::int64_t *X, const std::int64_t *Y, std::size_t N,
+           std::int64_t &Res) const;
+  // Y = A * X + Y.
+  void axpy(double A, const double *X, double *Y, std::size_t N) const {
+    mAxpy(A, X, Y, N);
+  }
+  bool axpy(std::int64_t A, const std::int64_t *X, std::int64_t *Y,
+            std::size_t N) const;
+  // Out may be one of the inputs.
+  void add(const double *X, const double *Y, double *Out,
+           std::size_t N) const {
+    mAdd(X, Y, Out, N);
+  }
+  bool add(const std::int64_t *X, const std::int64_t *Y, std::int64_t *Out,
+           std::size_t N) const {
+    return mAddInt(X, Y, Out, N);
+  }
+  void mul(const double *X, const double *Y, double *Out,
+           std::size_t N) const {
+    mMul(X, Y, Out, N);
+  }
+  bool mul(const std::int64_t *X, const std::int64_t *Y, std::int64_t *Out,
+           std::size_t N) const;
+  // Inclusive prefix sums, Out may be X.
+  void prefixSum(const double *X, double *Out, std::size_t N) const {
+    mPrefixSum(X, Out, N);
+  }
+  bool prefixSum(const std::int64_t *X, std::int64_t *Out,
+                 std::size_t N) const;
+
+  // Arrays are long enough for the widest vectors to pay off.
+  static ScanLevel getBestLevel();
+private:
+  typedef void (*FillFn)(std::uint64_t *, std::size_t, std::uint64_t);
+  typedef double (*ReduceFn)(const double *, std::size_t);
+  typedef bool (*SumIntFn)(const std::int64_t *, std::size_t,
+                           std::int64_t &);
+  typedef std::int64_t (*ReduceIntFn)(const std::int64_t *, std::size_t);
+  typedef double (*DotFn)(const double *, const double *, std::size_t);
+  typedef void (*AxpyFn)(double, const double *, double *, std::size_t);
+  typedef void (*BinaryFn)(const double *, const double *, double *,
+                           std::size_t);
+  typedef bool (*BinaryIntFn)(const std::int64_t *, const std::int64_t *,
+                              std::int64_t *, std::size_t);
+  typedef void (*ScanFn)(const double *, double *, std::size_t);
+  ScanLevel mLevel;
+  FillFn mFill;
+  ReduceFn mSum;
+  SumIntFn mSumInt;
+  ReduceFn mMin;
+  ReduceFn mMax;
+  ReduceIntFn mMinInt;
+  ReduceIntFn mMaxInt;
+  DotFn mDot;
+  AxpyFn mAxpy;
+  BinaryFn mAdd;
+  BinaryIntFn mAddInt;
+  BinaryFn mMul;
+  ScanFn mPrefixSum;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef __DRAGON_OPERATIONS__
+#define __DRAGON_OPERATIONS__
+
+#include "dragon/analysis/Bytecode.h"
+#include "dragon/structures/Arena.h"
+
+class InterpreterException : public std::exception {
+public:
+  InterpreterException(const std::string &Msg) {
+    mMsg = "[RUNTIME EXCEPTION] " + Msg + ".\n";
+  }
+  virtual const char *what() const noexcept { return mMsg.c_str(); }
+private:
+  std::string mMsg;
+};
+
+// Semantics of the operators on values, shared by the interpreter and the
+// constant folder. Strings produced by concatenation are placed in Strings
+// unless they are short enough to be stored inline, and so are integers that
+// overflow 64 bits.
+Value processUnary(Opcode Op, const Value &Top, const PosInfo &PI,
+                   Arena &Strings);
+Value processBinary(Opcode Op, const Value &OpLeft, const Value &OpRight,
+                    const PosInfo &PI, Arena &Strings);
+Value concat(std::string_view Left, std::string_view Right, Arena &Strings);
+// An int value if Int fits in 64 bits, a big integer otherwise.
+Value makeInteger(const BigInt &Int, Arena &Strings);
+
+template <typename T>
+inline Value processArithmetic(Opcode Op, T Left, T Right) {
+  switch (Op) {
+  case Opcode::EQ: return Value(Left == Right);
+  case Opcode::NE: return Value(Left != Right);
+  case Opcode::LT: return Value(Left < Right);
+  case Opcode::LE: return Value(Left <= Right);
+  case Opcode::GT: return Value(Left > Right);
+  case Opcode::GE: return Value(Left >= Right);
+  case Opcode::ADD: return Value(Left + Right);
+  case Opcode::SUB: return Value(Left - Right);
+  case Opcode::MUL: return Value(Left * Right);
+  case Opcode::DIV: return Value(Left / double(Right));
+  default: break;
+  }
+  assert(0 && "Unexpected arithmetic operation!");
+  return Value();
+}
+
+// Operators on two ints that stay within 64 bits. Returns false when the
+// result overflows or the operation fails, processBinary then promotes the
+// operands or reports the error.
+inline bool processInteger(Opcode Op, std::int64_t Left, std::int64_t Right,
+                           Value &Res) {
+  std::int64_t Int;
+  switch (Op) {
+  case Opcode::AND:
+  case Opcode::OR:
+    return false;
+  case Opcode::ADD:
+    if (__builtin_add_overflow(Left, Right, &Int))
+      return false;
+    break;
+  case Opcode::SUB:
+    if (__builtin_sub_overflow(Left, Right, &Int))
+      return false;
+    break;
+  case Opcode::MUL:
+    if (__builtin_mul_overflow(Left, Right, &Int))
+      return false;
+    break;
+  case Opcode::MOD:
+    if (Right == 0)
+      return false;
+    // The remainder of INT64_MIN by -1 is 0, but computing it traps.
+    Int = Right == -1 ? 0 : Left % Right;
+    break;
+  case Opcode::BIT_AND: Int = Left & Right; break;
+  case Opcode::BIT_OR: Int = Left | Right; break;
+  case Opcode::BIT_XOR: Int = Left ^ Right; break;
+  case Opcode::SHL:
+    if (Right < 0 || Right > 63)
+      return false;
+    Int = static_cast<std::int64_t>(static_cast<std::uint64_t>(Left) << Right);
+    if ((Int >> Right) != Left)
+      return false;
+    break;
+  case Opcode::SHR:
+    if (Right < 0)
+      return false;
+    Int = Left >> std::min<std::int64_t>(Right, 63);
+    break;
+  default:
+    Res = processArithmetic(Op, Left, Right);
+    return true;
+  }
+  Res = Value(Int);
+  return true;
+}
+
+// Fast path of processBinary for numeric operands. Returns false when the
+// operation has to go through processBinary, either because of the operand
+// types or because it fails or overflows.
+inline bool processNumeric(Opcode Op, const Value &OpLeft,
+                           const Value &OpRight, Value &Res) {
+  if (OpLeft.isInt() && OpRight.isInt())
+    return processInteger(Op, OpLeft.getInt(), OpRight.getInt(), Res);
+  if (!OpLeft.isNumber() || !OpRight.isNumber())
+    return false;
+  switch (Op) {
+  case Opcode::EQ:
+  case Opcode::NE:
+  case Opcode::LT:
+  case Opcode::LE:
+  case Opcode::GT:
+  case Opcode::GE:
+  case Opcode::ADD:
+  case Opcode::SUB:
+  case Opcode::MUL:
+  case Opcode::DIV:
+    Res = processArithmetic(Op, OpLeft.getNumber(), OpRight.getNumber());
+    return true;
+  default:
+    return false;
+  }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef __DRAGON_OPTIMIZER__
+#define __DRAGON_OPTIMIZER__
+
+#include "dragon/analysis/Bytecode.h"
+#include "dragon/structures/Arena.h"
+#include <optional>
+
+// Peephole passes over the bytecode of a single function:
+// - operators applied to constants are folded, a negated condition followed
+//   by a jump becomes JMP_IF_FALSE and branches on constant conditions are
+//   resolved;
+// - jumps to unconditional jumps are threaded to the final target;
+// - the hottest statement patterns get a fused instruction in front of them.
+// Jump targets are never merged into the preceding instructions.
+class Optimizer {
+public:
+  Optimizer(CompiledFunction &CF);
+private:
+  struct Entry {
+    Instruction I;
+    PosInfo PI;
+    bool IsTarget;
+  };
+  void foldConstants();
+  void threadJumps();
+  void fuseInstructions();
+  bool reduceTail();
+  bool foldUnary();
+  bool foldBinary();
+  bool foldBranch();
+  std::optional<Instruction> matchFused(std::size_t PC,
+                                        const std::vector<bool> &IsTarget);
+  std::vector<bool> findTargets() const;
+  void replaceCode(const std::vector<std::size_t> &NewPC);
+  CompiledFunction &mCF;
+  std::vector<Entry> mOut;
+  // Scratch memory for strings produced by folding, they are copied into the
+  // constant pool of the function.
+  Arena mStrings;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef __DRAGON_PROGRAM_CACHE__
+#define __DRAGON_PROGRAM_CACHE__
+
+#include "dragon/analysis/Compiler.h"
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+
+class CacheException : public std::exception {
+public:
+  CacheException(const std::string &Msg) {
+    mMsg = "[CACHE EXCEPTION] " + Msg + ".\n";
+  }
+  virtual const char *what() const noexcept { return mMsg.c_str(); }
+private:
+  std::string mMsg;
+};
+
+// Compiled form of a script stored next to it (`.drc`). The file starts
+// with a fixed header followed by 8-byte aligned sections which are read
+// straight from the mapping: function records, local names, code,
+// positions, constants and string data. A cache is only used if it was
+// built from a source with the same hash and at the same optimization level.
+class ProgramCache {
+public:
+  static std::uint64_t hashSource(std::string_view Source);
+  static std::string getCachePath(std::string_view SourcePath);
+  static void write(const std::string &Path, std::uint64_t SourceHash,
+                    unsigned OptLevel, const Compiler::FuncList &Funcs);
+  // Returns nothing if there is no valid cache for the source.
+  static std::optional<Compiler::FuncList> load(const std::string &Path,
+                                                std::uint64_t SourceHash,
+                                                unsigned OptLevel);
+};
+
+#endif
\ No newline at end of file
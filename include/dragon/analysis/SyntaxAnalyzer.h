@@ -2,20 +2,43 @@
 #define __DRAGON_SYNTAX_ANALYZER__
 
 #include "dragon/analysis/LexicalAnalyzer.h"
+#include <map>
 
 typedef std::vector<std::vector<Token *>> PostfixList;
 
 class Function {
 public:
-  Function(const std::string &Name) : mName(Name) {}
-  std::string getName() const { return mName; }
+  typedef LexicalAnalyzer::TokenList::const_iterator LineIterator;
+  Function(std::string_view Name, std::size_t Index)
+      : mName(Name), mIndex(Index) {}
+  const std::string &getName() const { return mName; }
+  std::size_t getIndex() const { return mIndex; }
   void addParam(Identifier *Param) { mParams.push_back(Param); }
   const std::vector<Identifier *> &getParamList() const { return mParams; }
+  // Source lines of the body, the closing `return` line included.
+  void setBody(LineIterator Begin, LineIterator End) {
+    mBodyBegin = Begin;
+    mBodyEnd = End;
+  }
+  LineIterator getBodyBegin() const { return mBodyBegin; }
+  LineIterator getBodyEnd() const { return mBodyEnd; }
+  void setReturnsValue() { mReturnsValue = true; }
+  bool returnsValue() const { return mReturnsValue; }
+  bool hasPostfix() const { return mHasPostfix; }
   PostfixList &getPostfixList() { return mPL; }
-  const PostfixList &getPostfixList() const { return mPL; }
+  const PostfixList &getPostfixList() const {
+    assert(mHasPostfix && "Postfix of the function is not generated yet!");
+    return mPL;
+  }
 private:
+  friend class SyntaxAnalyzer;
   std::string mName;
+  std::size_t mIndex;
   std::vector<Identifier *> mParams;
+  LineIterator mBodyBegin;
+  LineIterator mBodyEnd;
+  bool mReturnsValue = false;
+  bool mHasPostfix = false;
   PostfixList mPL;
 };
 
@@ -33,13 +56,20 @@ class SyntaxAnalyzer {
   typedef LexicalAnalyzer::TokenList TokenList;
   typedef std::vector<std::vector<Token *>> TokenPtrList;
 public:
-  typedef std::map<std::string, Function> FuncMap;
-  SyntaxAnalyzer(const LexicalAnalyzer &LA);
-  const FuncMap &getFuncMap() const { return mFuncMap; }
+  typedef std::vector<Function> FuncList;
+  // In lazy mode only declarations and the global code are analyzed up
+  // front, function bodies wait for generateFunction().
+  SyntaxAnalyzer(const LexicalAnalyzer &LA, bool Lazy=false);
+  const FuncList &getFuncList() const { return mFuncs; }
+  // Generates the postfix form of the body of function Idx, if it hasn't
+  // been generated yet.
+  void generateFunction(std::size_t Idx);
+  std::optional<std::size_t> findFunction(std::string_view Name) const;
   void dump() const;
 private:
   void generatePostfix(const TokenPtrList &TL, Function &F);
-  FuncMap mFuncMap;
+  FuncList mFuncs;
+  std::map<std::string, std::size_t, std::less<>> mFuncIndices;
   std::vector<std::unique_ptr<Token>> mTmpTokens;
 };
 
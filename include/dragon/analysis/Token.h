@@ -2,38 +2,98 @@
 #define __DRAGON_TOKEN__
 
 #include "dragon/Common.h"
-#include "dragon/structures/Bimap.h"
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
-#define KEYPAIR(x, y) std::make_pair(x, y)
-
 typedef unsigned long PosType;
 typedef std::pair<PosType, PosType> PosInfo;
 
+// Dynamic type of a token. The kinds of derived classes directly follow the
+// kind of their base, so every class covers a contiguous range of kinds.
+enum class TokenKind : std::uint8_t {
+  TOKEN,
+  WORD,
+  KEYWORD,
+  POSTFIX_OPERATOR,
+  PREFIX_OPERATOR,
+  BINARY_OPERATOR,
+  BRACKET,
+  KEYWORDS_END,
+  IDENTIFIER,
+  FUNCTION_CALL,
+  BUILTIN_CALL,
+  IDENTIFIERS_END,
+  WORDS_END,
+  CONSTANT,
+  STRING,
+  FLOAT,
+  INTEGER,
+  BOOLEAN,
+  CONSTANTS_END
+};
+
 class Token {
 public:
   Token() {}
   Token(const PosInfo &LineCol) : mPI(LineCol) {}
   Token(PosType Line, PosType Column) : mPI(Line, Column) {}
+  TokenKind getTokenKind() const { return mTokenKind; }
+  static bool classof(const Token *) { return true; }
   virtual std::string toString() const { return "<unknown token>"; }
-  std::string getPos() const { return std::to_string(mPI.first) + ":" +
-                                      std::to_string(mPI.second); }
+  std::string getPos() const { return posToString(mPI); }
+  static std::string posToString(const PosInfo &PI) {
+    return std::to_string(PI.first) + ":" + std::to_string(PI.second);
+  }
   const PosInfo &getPosInfo() const { return mPI; }
   virtual Token *clone() const { return new Token(); }
   virtual ~Token() {}
 protected:
+  Token(TokenKind TK) : mTokenKind(TK) {}
+  Token(TokenKind TK, const PosInfo &PI) : mPI(PI), mTokenKind(TK) {}
   PosInfo mPI;
+  TokenKind mTokenKind = TokenKind::TOKEN;
 };
 
+// Casts between token classes driven by the token kind instead of RTTI.
+template <typename T> bool isa(const Token *Tok) { return T::classof(Tok); }
+
+template <typename T> T *cast(Token *Tok) {
+  assert(isa<T>(Tok) && "Invalid token cast!");
+  return static_cast<T *>(Tok);
+}
+
+template <typename T> const T *cast(const Token *Tok) {
+  assert(isa<T>(Tok) && "Invalid token cast!");
+  return static_cast<const T *>(Tok);
+}
+
+template <typename T> T *dyn_cast(Token *Tok) {
+  return isa<T>(Tok) ? static_cast<T *>(Tok) : nullptr;
+}
+
+template <typename T> const T *dyn_cast(const Token *Tok) {
+  return isa<T>(Tok) ? static_cast<const T *>(Tok) : nullptr;
+}
+
 class Word : public Token {
 public:
-  Word() {}
-  Word(const PosInfo &PI) : Token(PI) {}
+  Word() : Token(TokenKind::WORD) {}
+  Word(const PosInfo &PI) : Token(TokenKind::WORD, PI) {}
   std::string toString() const { return "<word>"; }
   Token *clone() const { return new Word(); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() >= TokenKind::WORD &&
+           Tok->getTokenKind() < TokenKind::WORDS_END;
+  }
   ~Word() {}
+protected:
+  Word(TokenKind TK) : Token(TK) {}
+  Word(TokenKind TK, const PosInfo &PI) : Token(TK, PI) {}
 };
 
 class Keyword : public Word {
@@ -47,6 +107,8 @@ public:
     BRACKETS_BEGIN,
     LEFT_PARENTHESIS,
     RIGHT_PARENTHESIS,
+    LEFT_SQUARE_BRACKET,
+    RIGHT_SQUARE_BRACKET,
     BRACKETS_END,
 
     /* unary operators (prefix) */
@@ -56,15 +118,22 @@ public:
     UNARY_PLUS,
     UNARY_MINUS,
     LOGICAL_NOT,
+    LEN,
     RETURN,
     COMMA,
+    COLON,
     IF,
     ELSE,
     ENDIF,
     WHILE,
     ENDWHILE,
+    FOR,
+    ENDFOR,
     GOTO_UN,
     GLOBAL,
+    DELETE,
+    SLICE,
+    MAKE_ARRAY,
     UNARY_END,
 
     /* binary operators */
@@ -88,78 +157,98 @@ public:
     MINUS,
     MULTIPLY,
     DIVIDE,
+    IN,
     GOTO_BIN,
+    FOR_NEXT,
+    INDEX,
     BINARY_END
   };
-  explicit Keyword(Kind Kind) : mKind(Kind) {}
-  explicit Keyword(Kind Kind, const PosInfo &PI) : Word(PI), mKind(Kind) {}
-  explicit Keyword(const std::string &WordStr, const PosInfo &PI) : Word(PI) {
-    auto Key = mKindToName.getValue(WordStr);
-    assert(Key && "Keyword must have a kind!");
-    mKind = *Key;
-  }
+  explicit Keyword(Kind Kind) : Word(TokenKind::KEYWORD), mKind(Kind) {}
+  explicit Keyword(Kind Kind, const PosInfo &PI)
+      : Word(TokenKind::KEYWORD, PI), mKind(Kind) {}
 
-  static bool isKeyword(const std::string &Word) {
-    return mKindToName.hasValue(Word);
-  }
+  // Kind of an alphabetic keyword such as `while`, if the word is one.
+  static std::optional<Kind> getWordKind(std::string_view Word);
+  // Matches the longest operator at the beginning of the string and returns
+  // its length, or 0 if the string doesn't start with an operator.
+  static std::size_t matchOperator(std::string_view Str, Kind &K);
 
   std::string kindToString() const {
-    auto Res = mKindToName.getValue(mKind);
-    assert(Res && "Keyword must be of declared kind!");
-    return *Res;
+    assert(!mNames[mKind].empty() && "Keyword must be of declared kind!");
+    return std::string(mNames[mKind]);
   }
 
   std::string toString() const {
-    auto Key = mKindToName.getValue(mKind);
-    return Key ? ("<kw: " + *Key + ">") : "<unknown keyword>";
+    auto Name = mNames[mKind];
+    return Name.empty() ? "<unknown keyword>" :
+                          "<kw: " + std::string(Name) + ">";
   }
 
   Kind getKind() const { return mKind; }
 
   Priority getPriority() const {
-    auto Itr = mKindToPriority.find(mKind);
-    assert(Itr != mKindToPriority.end() &&
+    assert(mPriorities[mKind] != NoPriority &&
         "Every keyword must have a priority!");
-    return Itr->second;
+    return mPriorities[mKind];
   }
 
   Token *clone() const { return new Keyword(mKind); }
 
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() >= TokenKind::KEYWORD &&
+           Tok->getTokenKind() < TokenKind::KEYWORDS_END;
+  }
+
   static bool isPunctChar(char Char) {
-    return mPunctuations.find(Char) != mPunctuations.npos;
+    return mPunctChars[static_cast<unsigned char>(Char)];
   }
-  
-  static const std::string &getPunctStr() { return mPunctuations; }
 
-  static void addDynamicKeyword(const std::string &Word,
+  static constexpr std::string_view getPunctStr() { return mPunctuations; }
+
+  static void addDynamicKeyword(Kind K,
                                 std::vector<std::unique_ptr<Token>> &TL,
                                 const PosInfo &PI);
 
-  static bool isForbiddenKeyword(const std::string &Kw) {
-    return mForbiddenKws.find(Kw) != mForbiddenKws.end();
-  };
+  // Keywords generated by the parser, a script can't spell them.
+  static bool isForbiddenKeyword(Kind K) { return mForbidden[K]; }
   virtual ~Keyword() {}
+protected:
+  Keyword(Kind Kind, TokenKind TK) : Word(TK), mKind(Kind) {}
+  Keyword(Kind Kind, const PosInfo &PI, TokenKind TK)
+      : Word(TK, PI), mKind(Kind) {}
 private:
-  static const std::string mPunctuations;
-  static const Bimap<Kind, std::string> mKindToName;
-  static const std::map<Kind, Priority> mKindToPriority;
-  static const std::set<std::string> mForbiddenKws;
+  static constexpr std::size_t KindCount = BINARY_END + 1;
+  static constexpr Priority NoPriority = -2;
+  static constexpr std::string_view mPunctuations = "+,-*/%^|&!()[]:<>=\"";
+  // Per-kind metadata, generated from the keyword table in Token.cpp.
+  static const std::array<std::string_view, KindCount> mNames;
+  static const std::array<Priority, KindCount> mPriorities;
+  static const std::array<bool, KindCount> mForbidden;
+  static const std::array<bool, 256> mPunctChars;
   Kind mKind;
 };
 
 class PostfixOperator : public Keyword {
 public:
-  explicit PostfixOperator(Kind Kind) : Keyword(Kind) {}
-  explicit PostfixOperator(Kind Kind, const PosInfo &PI) : Keyword(Kind, PI) {}
+  explicit PostfixOperator(Kind Kind) : Keyword(Kind, TokenKind::POSTFIX_OPERATOR) {}
+  explicit PostfixOperator(Kind Kind, const PosInfo &PI)
+      : Keyword(Kind, PI, TokenKind::POSTFIX_OPERATOR) {}
   Token *clone() const { return new PostfixOperator(this->getKind()); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::POSTFIX_OPERATOR;
+  }
   virtual ~PostfixOperator() {}
 };
 
 class PrefixOperator : public Keyword {
 public:
-  explicit PrefixOperator(Kind Kind) : Keyword(Kind) {}
-  explicit PrefixOperator(Kind Kind, const PosInfo &PI) : Keyword(Kind, PI) {}
+  explicit PrefixOperator(Kind Kind) : Keyword(Kind, TokenKind::PREFIX_OPERATOR) {}
+  explicit PrefixOperator(Kind Kind, const PosInfo &PI)
+      : Keyword(Kind, PI, TokenKind::PREFIX_OPERATOR) {}
   Token *clone() const { return new PrefixOperator(this->getKind()); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::PREFIX_OPERATOR;
+  }
   virtual ~PrefixOperator() {}
 };
 
@@ -167,14 +256,18 @@ class BinaryOperator : public Keyword {
 public:
   enum AssocKind { RIGHT, LEFT };
   explicit BinaryOperator(Kind Kind, AssocKind AssocKind=LEFT)
-      : Keyword(Kind), mAssocKind(AssocKind) {}
+      : Keyword(Kind, TokenKind::BINARY_OPERATOR), mAssocKind(AssocKind) {}
   explicit BinaryOperator(Kind Kind, const PosInfo &PI,
                           AssocKind AssocKind=LEFT)
-      : Keyword(Kind, PI), mAssocKind(AssocKind) {}
+      : Keyword(Kind, PI, TokenKind::BINARY_OPERATOR),
+        mAssocKind(AssocKind) {}
   AssocKind getAssocKind() const { return mAssocKind; }
   Token *clone() const {
     return new BinaryOperator(this->getKind(), mAssocKind);
   }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::BINARY_OPERATOR;
+  }
   virtual ~BinaryOperator() {}
 private:
   AssocKind mAssocKind;
@@ -182,62 +275,136 @@ private:
 
 class Bracket : public Keyword {
 public:
-  explicit Bracket(Kind Kind) : Keyword(Kind) {}
-  explicit Bracket(Kind Kind, const PosInfo &PI) : Keyword(Kind, PI) {}
+  explicit Bracket(Kind Kind) : Keyword(Kind, TokenKind::BRACKET) {}
+  explicit Bracket(Kind Kind, const PosInfo &PI)
+      : Keyword(Kind, PI, TokenKind::BRACKET) {}
   Token *clone() const { return new Bracket(this->getKind()); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::BRACKET;
+  }
   virtual ~Bracket() {}
 };
 
 class Identifier : public Word {
 public:
-  Identifier(const std::string &Name) : mName(Name) {}
-  Identifier(const std::string &Name, const PosInfo &PI)
-      : Word(PI), mName(Name) {}
-  std::string getName() const { return mName; }
-  std::string toString() const { return "<id: " + mName + ">"; }
+  Identifier(std::string_view Name)
+      : Word(TokenKind::IDENTIFIER), mName(Name) {}
+  Identifier(std::string_view Name, const PosInfo &PI)
+      : Word(TokenKind::IDENTIFIER, PI), mName(Name) {}
+  std::string_view getName() const { return mName; }
+  std::string toString() const {
+    return "<id: " + std::string(mName) + ">";
+  }
   Token *clone() const { return new Identifier(this->getName()); }
   Identifier *cloneIdentifier() const { return new Identifier(this->getName());}
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() >= TokenKind::IDENTIFIER &&
+           Tok->getTokenKind() < TokenKind::IDENTIFIERS_END;
+  }
   virtual ~Identifier() {}
+protected:
+  Identifier(std::string_view Name, const PosInfo &PI, TokenKind TK)
+      : Word(TK, PI), mName(Name) {}
+private:
+  // Points into the source buffer the token was lexed from.
+  std::string_view mName;
+};
+
+class FunctionCall : public Identifier {
+public:
+  FunctionCall(std::string_view Name, std::size_t Index)
+      : FunctionCall(Name, Index, PosInfo()) {}
+  FunctionCall(std::string_view Name, std::size_t Index,
+               const PosInfo &PI)
+      : Identifier(Name, PI, TokenKind::FUNCTION_CALL), mIndex(Index) {}
+  std::size_t getIndex() const { return mIndex; }
+  std::string toString() const {
+    return "<call: " + std::string(getName()) + " #" + std::to_string(mIndex) + ">";
+  }
+  Token *clone() const { return new FunctionCall(getName(), mIndex); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::FUNCTION_CALL;
+  }
+  virtual ~FunctionCall() {}
 private:
-  std::string mName;
+  std::size_t mIndex;
+};
+
+// Call of a function implemented by the interpreter, Index is its position
+// in the builtin table.
+class BuiltinCall : public Identifier {
+public:
+  BuiltinCall(std::string_view Name, std::size_t Index)
+      : BuiltinCall(Name, Index, PosInfo()) {}
+  BuiltinCall(std::string_view Name, std::size_t Index, const PosInfo &PI)
+      : Identifier(Name, PI, TokenKind::BUILTIN_CALL), mIndex(Index) {}
+  std::size_t getIndex() const { return mIndex; }
+  std::string toString() const {
+    return "<builtin: " + std::string(getName()) + " #" +
+           std::to_string(mIndex) + ">";
+  }
+  Token *clone() const { return new BuiltinCall(getName(), mIndex); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::BUILTIN_CALL;
+  }
+  virtual ~BuiltinCall() {}
+private:
+  std::size_t mIndex;
 };
 
 class Constant : public Token {
 public:
-  Constant() {}
-  Constant(const PosInfo &PI) : Token(PI) {}
+  Constant() : Token(TokenKind::CONSTANT) {}
+  Constant(const PosInfo &PI) : Token(TokenKind::CONSTANT, PI) {}
   std::string toString() const { return "<unknown constant>"; }
   Token *clone() const { return new Constant(); }
   virtual Constant *cloneConst() const { return new Constant(); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() >= TokenKind::CONSTANT &&
+           Tok->getTokenKind() < TokenKind::CONSTANTS_END;
+  }
   virtual ~Constant() {}
+protected:
+  Constant(TokenKind TK) : Token(TK) {}
+  Constant(TokenKind TK, const PosInfo &PI) : Token(TK, PI) {}
 };
 
 class String : public Constant {
 public:
-  String(const std::string &Str) : mString(Str) {}
-  String(const std::string &Str, const PosInfo &PI)
-      : Constant(PI), mString(Str) {}
-  std::string getValue() const { return mString; }
+  String(std::string_view Str)
+      : Constant(TokenKind::STRING), mString(Str) {}
+  String(std::string_view Str, const PosInfo &PI)
+      : Constant(TokenKind::STRING, PI), mString(Str) {}
+  std::string_view getValue() const { return mString; }
   std::string toString() const {
-    return "<literal: " + (mString.empty() ? "(empty)" : mString) + ">";
+    return "<literal: " + (mString.empty() ? std::string("(empty)") :
+                                               std::string(mString)) + ">";
   }
   Token *clone() const { return new String(mString); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::STRING;
+  }
   virtual Constant *cloneConst() const { return new String(mString); }
   virtual ~String() {}
 private:
-  std::string mString;
+  // Points into the source buffer the token was lexed from.
+  std::string_view mString;
 };
 
 class Float : public Constant {
 public:
-  Float(double Value) : mValue(Value) {}
-  Float(double Value, const PosInfo &PI) : Constant(PI), mValue(Value) {}
-  double getValue() { return mValue; }
+  Float(double Value) : Constant(TokenKind::FLOAT), mValue(Value) {}
+  Float(double Value, const PosInfo &PI)
+      : Constant(TokenKind::FLOAT, PI), mValue(Value) {}
+  double getValue() const { return mValue; }
   double setValue(double Value) { mValue = Value; return mValue; }
   std::string toString() const {
     return "<float: " + std::to_string(mValue) + ">";
   }
   Token *clone() const { return new Float(mValue); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::FLOAT;
+  }
   virtual Constant *cloneConst() const { return new Float(mValue); }
   virtual ~Float() {}
 private:
@@ -246,38 +413,48 @@ private:
 
 class Integer : public Constant {
 public:
-  Integer(int Value) : mValue(Value) {}
-  Integer(int Value, const PosInfo &PI) : Constant(PI), mValue(Value) {}
-  int getValue() { return mValue; }
-  int setValue(int Value) { mValue = Value; return mValue; }
+  Integer(std::int64_t Value) : Constant(TokenKind::INTEGER), mValue(Value) {}
+  Integer(std::int64_t Value, const PosInfo &PI)
+      : Constant(TokenKind::INTEGER, PI), mValue(Value) {}
+  std::int64_t getValue() const { return mValue; }
+  std::int64_t setValue(std::int64_t Value) { mValue = Value; return mValue; }
   std::string toString() const {
     return "<int: " + std::to_string(mValue) + ">";
   }
   Token *clone() const { return new Integer(mValue); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::INTEGER;
+  }
   virtual Constant *cloneConst() const { return new Integer(mValue); }
   virtual ~Integer() {}
 private:
-  int mValue;
+  std::int64_t mValue;
 };
 
 class Boolean : public Constant {
 public:
-  Boolean(const std::string &Str) : mValue(Str == "true" ? true : false) {}
-  Boolean(const std::string &Str, const PosInfo &PI)
-      : Constant(PI), mValue(Str == "true" ? true : false) {}
-  Boolean(bool Value) : mValue(Value) {}
-  Boolean(bool Value, const PosInfo &PI) : Constant(PI), mValue(Value) {}
-  bool getValue() { return mValue; }
+  Boolean(std::string_view Str)
+      : Constant(TokenKind::BOOLEAN), mValue(Str == "true" ? true : false) {}
+  Boolean(std::string_view Str, const PosInfo &PI)
+      : Constant(TokenKind::BOOLEAN, PI),
+        mValue(Str == "true" ? true : false) {}
+  Boolean(bool Value) : Constant(TokenKind::BOOLEAN), mValue(Value) {}
+  Boolean(bool Value, const PosInfo &PI)
+      : Constant(TokenKind::BOOLEAN, PI), mValue(Value) {}
+  bool getValue() const { return mValue; }
   bool setValue(bool Value) { mValue = Value; return mValue; }
   std::string toString() const {
     return "<bool: " + std::string(mValue == true ? "true" : "false") + ">";
   }
 
-  static bool isBoolean(const std::string &Str) {
+  static bool isBoolean(std::string_view Str) {
     return Str == "true" || Str == "false";
   }
 
   Token *clone() const { return new Boolean(mValue); }
+  static bool classof(const Token *Tok) {
+    return Tok->getTokenKind() == TokenKind::BOOLEAN;
+  }
   virtual Constant *cloneConst() const { return new Boolean(mValue); }
   virtual ~Boolean() {}
 private:
@@ -0,0 +1,284 @@
+#ifndef __DRAGON_VALUE__
+#define __DRAGON_VALUE__
+
+#include "dragon/Common.h"
+#include "dragon/analysis/BigInt.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// String payload, the characters are stored right after the header. Big
+// integers are kept in the same objects in their flat form, and so are the
+// elements of arrays, which is the only payload written in place. Objects
+// are placed either in an arena (temporaries), in a reference counted heap
+// buffer shared by variables or in the constant pool of a function. Only
+// heap objects are counted.
+//
+// A value refers to a prefix of an object. The characters of every prefix are
+// never changed, but a heap object may grow at the end into its spare
+// capacity: the concatenation of a value that ends where the object ends is
+// appended in place.
+// The header keeps the payload aligned for array elements.
+class alignas(8) StringObject {
+public:
+  enum : std::uint32_t {
+    Temporary = 0,
+    Static = ~0u
+  };
+
+  std::uint32_t getLength() const { return mLength; }
+  std::uint32_t getCapacity() const { return mCapacity; }
+  char *getData() { return reinterpret_cast<char *>(this + 1); }
+  const char *getData() const {
+    return reinterpret_cast<const char *>(this + 1);
+  }
+  std::string_view getView() const {
+    return std::string_view(getData(), mLength);
+  }
+  // Whether a prefix of the given length can be extended in place by Extra
+  // characters.
+  bool canAppend(std::uint32_t Length, std::size_t Extra) const {
+    return isCounted() && Length == mLength && Extra <= mCapacity - mLength;
+  }
+  // Every value sees only its own prefix, so appending doesn't change any of
+  // them.
+  void append(std::string_view Str) const {
+    assert(Str.size() <= mCapacity - mLength && "Not enough capacity!");
+    std::copy(Str.begin(), Str.end(),
+              const_cast<char *>(getData()) + mLength);
+    mLength += Str.size();
+  }
+
+  // A dict keeps its table out of line, the payload is the Dict itself.
+  bool holdsDict() const { return mHoldsDict; }
+  bool isTemporary() const { return mRefCount == Temporary; }
+  bool isCounted() const {
+    return mRefCount != Temporary && mRefCount != Static;
+  }
+  std::uint32_t getRefCount() const { return mRefCount; }
+  void retain() const { assert(isCounted()); ++mRefCount; }
+  // Returns true if the last reference was dropped, the owner then destroys
+  // the object.
+  bool release() const { assert(isCounted()); return --mRefCount == 0; }
+  static void destroy(const StringObject *Obj);
+
+  static std::size_t getAllocSize(std::size_t Length) {
+    return sizeof(StringObject) + Length;
+  }
+  // Places an object of the given length into Mem, which must be at least
+  // getAllocSize(Capacity) bytes. The characters are left for the caller.
+  static StringObject *create(void *Mem, std::size_t Length,
+                              std::uint32_t RefCount=Temporary,
+                              std::size_t Capacity=0) {
+    return new (Mem) StringObject(Length, RefCount,
+                                  std::max(Length, Capacity));
+  }
+  static StringObject *create(void *Mem, std::string_view Str,
+                              std::uint32_t RefCount=Temporary,
+                              std::size_t Capacity=0) {
+    auto Obj = create(Mem, Str.size(), RefCount, Capacity);
+    std::copy(Str.begin(), Str.end(), Obj->getData());
+    return Obj;
+  }
+private:
+  friend class Dict;
+  StringObject(std::size_t Length, std::uint32_t RefCount,
+               std::size_t Capacity)
+      : mLength(Length), mRefCount(RefCount), mCapacity(Capacity) {}
+  mutable std::uint32_t mLength;
+  mutable std::uint32_t mRefCount;
+  std::uint32_t mCapacity;
+  bool mHoldsDict = false;
+};
+
+class Dict;
+
+// A value is two words wide. Strings of up to MaxInlineLength characters are
+// stored in the value itself, longer ones point to a StringObject and hold
+// their length. Either way a copy of a value costs the same.
+class Value {
+public:
+  enum Type : std::uint8_t {
+    NIL = 0,
+    INTEGER,
+    FLOAT,
+    BOOLEAN,
+    STRING,
+    BIGINT,   // an integer outside of the 64-bit range
+    ARRAY,    // fixed-length array of unboxed ints or floats
+    DICT      // hash table from ints and strings to any values
+  };
+  static constexpr std::size_t MaxInlineLength = 14;
+
+  Value() : mType(NIL) { set(0); }
+  template <typename T, typename = std::enable_if_t<
+      std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+  explicit Value(T Int) : mType(INTEGER) {
+    set(static_cast<std::int64_t>(Int));
+  }
+  explicit Value(double Float) : mType(FLOAT) { set(Float); }
+  explicit Value(bool Bool) : mType(BOOLEAN) { set(Bool); }
+  explicit Value(const StringObject *Str)
+      : Value(Str, Str->getLength()) {}
+  Value(const StringObject *Str, std::uint32_t Length) : mType(STRING) {
+    set(Str);
+    set(Length, sizeof(Str));
+  }
+  // Value of a big integer whose flat form is held by Obj.
+  static Value makeBigInt(const StringObject *Obj) {
+    Value Val(Obj);
+    Val.mType = BIGINT;
+    return Val;
+  }
+  // Value of an array whose elements are held by Obj. ElementType is
+  // INTEGER or FLOAT; every reference to the array agrees on it.
+  static Value makeArray(const StringObject *Obj, Type ElementType) {
+    assert((ElementType == INTEGER || ElementType == FLOAT) &&
+           "Arrays hold only numbers!");
+    Value Val;
+    Val.mType = ARRAY;
+    Val.set(Obj);
+    Val.set(ElementType, sizeof(Obj));
+    return Val;
+  }
+  // Value of a dict created by Dict::create().
+  static Value makeDict(const StringObject *Obj) {
+    assert(Obj->holdsDict() && "Object holds no dict!");
+    Value Val;
+    Val.mType = DICT;
+    Val.set(Obj);
+    return Val;
+  }
+  static Value makeInline(std::string_view Str) {
+    assert(Str.size() <= MaxInlineLength && "String is too long!");
+    Value Val;
+    Val.mType = STRING;
+    Val.mInlineLength = Str.size();
+    std::copy(Str.begin(), Str.end(), Val.mData);
+    return Val;
+  }
+
+  Type getType() const { return mType; }
+  bool isNil() const { return mType == NIL; }
+  bool isInt() const { return mType == INTEGER; }
+  bool isFloat() const { return mType == FLOAT; }
+  bool isBool() const { return mType == BOOLEAN; }
+  bool isString() const { return mType == STRING; }
+  bool isNumber() const { return mType == INTEGER || mType == FLOAT; }
+  bool isInlineString() const {
+    return mType == STRING && mInlineLength != NotInline;
+  }
+  bool isBigInt() const { return mType == BIGINT; }
+  bool isArray() const { return mType == ARRAY; }
+  bool isDict() const { return mType == DICT; }
+  // A string held by a StringObject.
+  bool isStringObject() const {
+    return mType == STRING && mInlineLength == NotInline;
+  }
+  // Any value held by a StringObject. Only strings are ever inline.
+  bool hasObject() const {
+    return mType >= STRING && mInlineLength == NotInline;
+  }
+
+  std::int64_t getInt() const { assert(isInt()); return get<std::int64_t>(); }
+  double getFloat() const { assert(isFloat()); return get<double>(); }
+  bool getBool() const { assert(isBool()); return get<bool>(); }
+  // The view of an inline string points into the value.
+  std::string_view getString() const {
+    assert(isString());
+    if (mInlineLength != NotInline)
+      return std::string_view(mData, mInlineLength);
+    return getObjectView();
+  }
+  const StringObject *getStringObject() const {
+    assert(isStringObject());
+    return get<const StringObject *>();
+  }
+  const StringObject *getObject() const {
+    assert(hasObject());
+    return get<const StringObject *>();
+  }
+  BigInt getBigInt() const;
+  // A copy of the value that refers to Obj, which holds the same payload.
+  Value withObject(const StringObject *Obj) const {
+    Value Val = *this;
+    Val.set(Obj);
+    return Val;
+  }
+
+  Type getElementType() const {
+    assert(isArray());
+    return get<Type>(sizeof(StringObject *));
+  }
+  std::size_t getArrayLength() const {
+    return getObject()->getLength() / sizeof(std::int64_t);
+  }
+  std::int64_t *getInts() const {
+    assert(getElementType() == INTEGER);
+    return reinterpret_cast<std::int64_t *>(getElements());
+  }
+  double *getFloats() const {
+    assert(getElementType() == FLOAT);
+    return reinterpret_cast<double *>(getElements());
+  }
+  Value getElement(std::size_t Idx) const {
+    assert(Idx < getArrayLength() && "Index out of range!");
+    if (getElementType() == FLOAT)
+      return Value(getFloats()[Idx]);
+    return Value(getInts()[Idx]);
+  }
+  // Stores a number converted to the element type. Returns false if Elem
+  // isn't a number the array can hold: a float is never truncated into an
+  // int array.
+  bool setElement(std::size_t Idx, const Value &Elem) const {
+    assert(Idx < getArrayLength() && "Index out of range!");
+    if (getElementType() == FLOAT && Elem.isNumber())
+      getFloats()[Idx] = Elem.getNumber();
+    else if (getElementType() == INTEGER && Elem.isInt())
+      getInts()[Idx] = Elem.getInt();
+    else
+      return false;
+    return true;
+  }
+  double getNumber() const { return isInt() ? getInt() : getFloat(); }
+  // Like array elements, the table is changed through any reference.
+  Dict &getDict() const {
+    assert(isDict());
+    return *reinterpret_cast<Dict *>(getElements());
+  }
+
+  std::string toString() const;
+  static const char *typeToString(Type T);
+private:
+  static constexpr std::uint8_t NotInline = 0xff;
+
+  char *getElements() const {
+    return const_cast<char *>(getObject()->getData());
+  }
+  std::string_view getObjectView() const {
+    return std::string_view(getObject()->getData(),
+                            get<std::uint32_t>(sizeof(StringObject *)));
+  }
+  template <typename T> T get(std::size_t Offset=0) const {
+    T Val;
+    std::memcpy(&Val, mData + Offset, sizeof(T));
+    return Val;
+  }
+  template <typename T> void set(T Val, std::size_t Offset=0) {
+    std::memcpy(mData + Offset, &Val, sizeof(T));
+  }
+
+  // Scalars and object pointers are kept at the start of mData, the length
+  // of a string object or the element type of an array follows the pointer.
+  alignas(8) char mData[MaxInlineLength];
+  std::uint8_t mInlineLength = NotInline;
+  Type mType;
+};
+
+static_assert(sizeof(Value) <= 16, "Value must stay two words wide!");
+
+#endif
\ No newline at end of file
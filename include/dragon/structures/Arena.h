@@ -0,0 +1,75 @@
+#ifndef __DRAGON_ARENA__
+#define __DRAGON_ARENA__
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator with stack-like release. Chunks are kept after release and
+// reused, so a workload that repeatedly allocates and releases the same
+// amount of memory runs in a constant footprint. Every allocation is aligned
+// to Alignment bytes.
+class Arena {
+public:
+  static constexpr std::size_t Alignment = alignof(std::max_align_t);
+
+  struct Mark {
+    std::size_t Chunk;
+    std::size_t Offset;
+  };
+
+  explicit Arena(std::size_t ChunkSize=64 * 1024) : mChunkSize(ChunkSize) {}
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  char *allocate(std::size_t Size) {
+    Size = (Size + Alignment - 1) & ~(Alignment - 1);
+    if (!mChunks.empty() &&
+        mChunks[mCur.Chunk].Size - mCur.Offset >= Size) {
+      auto Ptr = mChunks[mCur.Chunk].Data.get() + mCur.Offset;
+      mCur.Offset += Size;
+      return Ptr;
+    }
+    return allocateSlow(Size);
+  }
+
+  Mark mark() const { return mCur; }
+
+  void release(const Mark &M) {
+    assert((M.Chunk < mCur.Chunk ||
+           (M.Chunk == mCur.Chunk && M.Offset <= mCur.Offset)) &&
+           "Arena can only be released to an earlier mark!");
+    mCur = M;
+  }
+
+  std::size_t getCapacity() const {
+    std::size_t Total = 0;
+    for (auto &C : mChunks)
+      Total += C.Size;
+    return Total;
+  }
+private:
+  struct Chunk {
+    std::unique_ptr<char[]> Data;
+    std::size_t Size;
+  };
+
+  char *allocateSlow(std::size_t Size) {
+    auto Next = mChunks.empty() ? 0 : mCur.Chunk + 1;
+    auto NewSize = std::max(Size, mChunkSize);
+    if (Next == mChunks.size())
+      mChunks.push_back({ std::make_unique<char[]>(NewSize), NewSize });
+    else if (mChunks[Next].Size < Size)
+      mChunks[Next] = { std::make_unique<char[]>(NewSize), NewSize };
+    mCur = { Next, Size };
+    return mChunks[Next].Data.get();
+  }
+
+  std::size_t mChunkSize;
+  std::vector<Chunk> mChunks;
+  Mark mCur = { 0, 0 };
+};
+
+#endif
\ No newline at end of file
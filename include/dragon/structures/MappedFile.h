@@ -0,0 +1,50 @@
+#ifndef __DRAGON_MAPPED_FILE__
+#define __DRAGON_MAPPED_FILE__
+
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of a whole file. The contents stay valid as long as the
+// object is alive.
+class MappedFile {
+public:
+  MappedFile(const char *Path) {
+    int FD = ::open(Path, O_RDONLY);
+    if (FD < 0)
+      return;
+    struct stat St;
+    if (::fstat(FD, &St) == 0 && S_ISREG(St.st_mode)) {
+      mSize = St.st_size;
+      mIsOpen = true;
+      if (mSize) {
+        void *Addr = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, FD, 0);
+        if (Addr == MAP_FAILED) {
+          mSize = 0;
+          mIsOpen = false;
+        } else {
+          mData = static_cast<const char *>(Addr);
+          ::madvise(Addr, mSize, MADV_SEQUENTIAL);
+        }
+      }
+    }
+    ::close(FD);
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+    if (mData)
+      ::munmap(const_cast<char *>(mData), mSize);
+  }
+
+  bool isOpen() const { return mIsOpen; }
+  std::string_view getView() const { return std::string_view(mData, mSize); }
+private:
+  const char *mData = nullptr;
+  std::size_t mSize = 0;
+  bool mIsOpen = false;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef __DRAGON_OUTPUT_BUFFER__
+#define __DRAGON_OUTPUT_BUFFER__
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string_view>
+
+// Buffer in front of the stream a program prints to. Numbers are formatted
+// with to_chars straight into the buffer; floats look like the default
+// iostream output (`%g`, 6 significant digits).
+class OutputBuffer {
+public:
+  enum class FlushPolicy {
+    LINE,  // after every newline
+    FULL,  // when the buffer is full
+    EXIT   // only by flush(); the buffer grows as needed until then
+  };
+  static constexpr std::size_t DefaultSize = 64 * 1024;
+
+  explicit OutputBuffer(std::ostream &Out, std::size_t Size=DefaultSize,
+                        FlushPolicy Policy=FlushPolicy::FULL)
+      : mOut(Out), mPolicy(Policy), mCapacity(Size ? Size : 1),
+        mData(new char[mCapacity]) {}
+  OutputBuffer(const OutputBuffer &) = delete;
+  OutputBuffer &operator=(const OutputBuffer &) = delete;
+  ~OutputBuffer() { flush(); }
+
+  FlushPolicy getPolicy() const { return mPolicy; }
+
+  void write(std::string_view Str) {
+    if (Str.size() > mCapacity - mSize) {
+      if (mPolicy == FlushPolicy::EXIT) {
+        grow(Str.size());
+      } else {
+        flushBuffer();
+        // Too long to be worth copying.
+        if (Str.size() >= mCapacity) {
+          mOut.write(Str.data(), Str.size());
+          return;
+        }
+      }
+    }
+    std::copy(Str.begin(), Str.end(), mData.get() + mSize);
+    mSize += Str.size();
+  }
+
+  void write(long long Int) {
+    char Buf[24];
+    auto Res = std::to_chars(Buf, Buf + sizeof(Buf), Int);
+    write(std::string_view(Buf, Res.ptr - Buf));
+  }
+
+  void write(double Float) {
+    // Longest `%g` output with 6 digits is "-1.23457e-308".
+    char Buf[32];
+    auto Res = std::to_chars(Buf, Buf + sizeof(Buf), Float,
+                             std::chars_format::general, 6);
+    write(std::string_view(Buf, Res.ptr - Buf));
+  }
+
+  void writeNewLine() {
+    write(std::string_view("\n"));
+    if (mPolicy == FlushPolicy::LINE)
+      flush();
+  }
+
+  // Hands everything written so far to the stream and flushes it.
+  void flush() {
+    flushBuffer();
+    mOut.flush();
+  }
+private:
+  std::ostream &mOut;
+  FlushPolicy mPolicy;
+  std::size_t mCapacity;
+  std::size_t mSize = 0;
+  std::unique_ptr<char[]> mData;
+
+  void flushBuffer() {
+    if (mSize)
+      mOut.write(mData.get(), mSize);
+    mSize = 0;
+  }
+
+  void grow(std::size_t Extra) {
+    auto NewCapacity = std::max(mCapacity * 2, mSize + Extra);
+    std::unique_ptr<char[]> NewData(new char[NewCapacity]);
+    std::copy(mData.get(), mData.get() + mSize, NewData.get());
+    mData = std::move(NewData);
+    mCapacity = NewCapacity;
+  }
+};
+
+#endif
\ No newline at end of file
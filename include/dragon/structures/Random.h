@@ -0,0 +1,59 @@
+#ifndef __DRAGON_RANDOM__
+#define __DRAGON_RANDOM__
+
+#include <cstdint>
+
+// xoshiro256** generator: a few cycles per number and good statistical
+// quality, but predictable from its output, so not fit for secrets.
+class Random {
+public:
+  explicit Random(std::uint64_t Seed=0) { seed(Seed); }
+
+  // The state is expanded from the seed with splitmix64, so similar seeds
+  // still give unrelated sequences.
+  void seed(std::uint64_t Seed) {
+    for (auto &Word : mState) {
+      Seed += 0x9e3779b97f4a7c15;
+      auto Z = Seed;
+      Z = (Z ^ (Z >> 30)) * 0xbf58476d1ce4e5b9;
+      Z = (Z ^ (Z >> 27)) * 0x94d049bb133111eb;
+      Word = Z ^ (Z >> 31);
+    }
+  }
+
+  std::uint64_t next() {
+    auto Res = rotl(mState[1] * 5, 7) * 9;
+    auto T = mState[1] << 17;
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+    mState[2] ^= T;
+    mState[3] = rotl(mState[3], 45);
+    return Res;
+  }
+
+  // Uniform in [0, 1), from the upper 53 bits.
+  double nextDouble() { return (next() >> 11) * 0x1p-53; }
+
+  // Uniform in [0, Bound), Bound must not be 0. The high half of a 128-bit
+  // product is the result; the rare low halves that would favour some
+  // results are drawn again.
+  std::uint64_t nextBelow(std::uint64_t Bound) {
+    auto Product = static_cast<unsigned __int128>(next()) * Bound;
+    if (static_cast<std::uint64_t>(Product) < Bound) {
+      auto Threshold = -Bound % Bound;
+      while (static_cast<std::uint64_t>(Product) < Threshold)
+        Product = static_cast<unsigned __int128>(next()) * Bound;
+    }
+    return Product >> 64;
+  }
+private:
+  std::uint64_t mState[4];
+
+  static std::uint64_t rotl(std::uint64_t X, int K) {
+    return (X << K) | (X >> (64 - K));
+  }
+};
+
+#endif
\ No newline at end of file
@@ -1,29 +1,128 @@
 #include "dragon/analysis/Interpreter.h"
-#include <iostream>
+#include "dragon/analysis/ProgramCache.h"
+#include "dragon/structures/MappedFile.h"
+#include <cstdlib>
 #include <fstream>
+#include <iostream>
 
 #define RED_TEXT "\033[1;31m"
 
 int main(int argc, char **argv) {
   std::cout << "DRAGON 1.0 is running." << std::endl;
-  if (argc < 2) {
+  const char *Filename = nullptr;
+  auto MaxCallDepth = Interpreter::DefaultMaxCallDepth;
+  auto OptLevel = Compiler::DefaultOptLevel;
+  bool Lazy = false;
+  bool CompileOnly = false;
+  auto BufferSize = OutputBuffer::DefaultSize;
+  auto Policy = OutputBuffer::FlushPolicy::FULL;
+  for (int Idx = 1; Idx < argc; ++Idx) {
+    std::string Arg(argv[Idx]);
+    if (Arg == "--max-call-depth") {
+      if (++Idx == argc) {
+        std::cerr << "Missing value for `" << Arg << "`." << std::endl;
+        return -1;
+      }
+      char *End;
+      auto Depth = std::strtoull(argv[Idx], &End, 10);
+      if (*End != '\0' || Depth == 0 || argv[Idx][0] == '-') {
+        std::cerr << "Invalid call depth `" << argv[Idx] << "`." << std::endl;
+        return -1;
+      }
+      MaxCallDepth = Depth;
+    } else if (Arg == "--output-buffer") {
+      if (++Idx == argc) {
+        std::cerr << "Missing value for `" << Arg << "`." << std::endl;
+        return -1;
+      }
+      char *End;
+      auto Size = std::strtoull(argv[Idx], &End, 10);
+      if (*End != '\0' || Size == 0 || argv[Idx][0] == '-') {
+        std::cerr << "Invalid buffer size `" << argv[Idx] << "`." << std::endl;
+        return -1;
+      }
+      BufferSize = Size;
+    } else if (Arg == "--flush") {
+      if (++Idx == argc) {
+        std::cerr << "Missing value for `" << Arg << "`." << std::endl;
+        return -1;
+      }
+      std::string Value(argv[Idx]);
+      if (Value == "line") {
+        Policy = OutputBuffer::FlushPolicy::LINE;
+      } else if (Value == "full") {
+        Policy = OutputBuffer::FlushPolicy::FULL;
+      } else if (Value == "exit") {
+        Policy = OutputBuffer::FlushPolicy::EXIT;
+      } else {
+        std::cerr << "Invalid flush policy `" << Value << "`." << std::endl;
+        return -1;
+      }
+    } else if (Arg == "--lazy") {
+      Lazy = true;
+    } else if (Arg == "--compile-only") {
+      CompileOnly = true;
+    } else if (Arg == "-O0" || Arg == "-O1") {
+      OptLevel = Arg[2] - '0';
+    } else if (!Filename) {
+      Filename = argv[Idx];
+    } else {
+      std::cerr << "Unexpected argument `" << Arg << "`." << std::endl;
+      return -1;
+    }
+  }
+  if (!Filename) {
     std::cerr << "Too few arguments. Please enter a filename." << std::endl;
     return -1;
   }
-  auto Filename = argv[1];
-  std::ifstream File;
-  File.open(Filename, std::ios::in);
-  if (!File.is_open()) {
-    std::cerr << "Failed to open file `" << Filename << "`." << std::endl;
-    return -1;
+  MappedFile File(Filename);
+  std::string_view Source = File.getView();
+  // Pipes and other inputs that cannot be mapped are read into memory
+  // instead. They have no stable contents to key a cache file on.
+  std::string Buffer;
+  bool UseCache = File.isOpen();
+  if (!UseCache) {
+    std::ifstream In(Filename, std::ios::binary);
+    if (!In) {
+      std::cerr << "Failed to open file `" << Filename << "`." << std::endl;
+      return -1;
+    }
+    if (CompileOnly) {
+      std::cerr << "Cannot cache a non-regular file `" << Filename << "`." <<
+                   std::endl;
+      return -1;
+    }
+    Buffer.assign(std::istreambuf_iterator<char>(In),
+                  std::istreambuf_iterator<char>());
+    Source = Buffer;
   }
+  OutputBuffer Out(std::cout, BufferSize, Policy);
   try {
-    LexicalAnalyzer LA(File);
-    SyntaxAnalyzer SA(LA);
-    Interpreter Int(SA);
+    auto Hash = ProgramCache::hashSource(Source);
+    auto CachePath = ProgramCache::getCachePath(Filename);
+    if (CompileOnly) {
+      LexicalAnalyzer LA(Source);
+      SyntaxAnalyzer SA(LA);
+      Compiler C(SA, OptLevel);
+      ProgramCache::write(CachePath, Hash, OptLevel, C.getFuncList());
+      return 0;
+    }
+    if (UseCache) {
+      if (auto Funcs = ProgramCache::load(CachePath, Hash, OptLevel)) {
+        Interpreter Int(*Funcs, Out, MaxCallDepth);
+        Int.run();
+        return 0;
+      }
+    }
+    LexicalAnalyzer LA(Source);
+    SyntaxAnalyzer SA(LA, Lazy);
+    Compiler C(SA, OptLevel);
+    Interpreter Int(C, Out, MaxCallDepth);
+    Int.run();
   } catch (std::exception &E) {
+    // Whatever the script printed before the error comes first.
+    Out.flush();
     std::cerr << RED_TEXT << E.what();
   }
-  File.close();
   return 0;
 }
\ No newline at end of file
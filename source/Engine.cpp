@@ -0,0 +1,93 @@
+#include "dragon/Engine.h"
+#include <limits>
+
+namespace {
+void releaseInput(const Value &Val) {
+  if (Val.hasObject() && Val.getObject()->release())
+    StringObject::destroy(Val.getObject());
+}
+} // namespace
+
+// Every function is compiled right away, nothing refers to the analyzers
+// afterwards.
+Program::Program(std::string_view Source, unsigned OptLevel) {
+  LexicalAnalyzer LA(Source);
+  SyntaxAnalyzer SA(LA);
+  Compiler C(SA, OptLevel);
+  mFuncs = C.takeFuncList();
+}
+
+std::optional<std::uint32_t> Program::findGlobal(
+    std::string_view Name) const {
+  // Slots the compiler keeps for itself are named with a `$`.
+  if (Name.empty() || Name.front() == '$')
+    return std::nullopt;
+  for (auto &Func : mFuncs) {
+    if (Func.getName() != GLOBAL_FUNC)
+      continue;
+    for (std::uint32_t Slot = 0; Slot < Func.getFrameSize(); ++Slot)
+      if (Func.getLocalName(Slot) == Name)
+        return Slot;
+  }
+  return std::nullopt;
+}
+
+// The output is only handed to the stream at the end of a run.
+Engine::Engine(const Program &P, std::size_t MaxCallDepth)
+    : mProgram(P), mOut(mStream, OutputBuffer::DefaultSize,
+                        OutputBuffer::FlushPolicy::EXIT),
+      mInterpreter(P.getFuncList(), mOut, MaxCallDepth) {}
+
+Engine::~Engine() { clearInputs(); }
+
+void Engine::setInput(std::string_view Name, const Value &Val) {
+  auto Slot = mProgram.findGlobal(Name);
+  if (!Slot) {
+    releaseInput(Val);
+    return;
+  }
+  for (auto &Input : mInputs) {
+    if (Input.first == *Slot) {
+      releaseInput(Input.second);
+      Input.second = Val;
+      return;
+    }
+  }
+  mInputs.emplace_back(*Slot, Val);
+}
+
+void Engine::setString(std::string_view Name, std::string_view Str) {
+  if (Str.size() <= Value::MaxInlineLength) {
+    setInput(Name, Value::makeInline(Str));
+    return;
+  }
+  if (Str.size() > std::numeric_limits<std::uint32_t>::max())
+    throw InterpreterException("String input `" + std::string(Name) +
+                               "` is too long");
+  auto Obj = StringObject::create(
+      new char[StringObject::getAllocSize(Str.size())], Str, 1);
+  setInput(Name, Value(Obj));
+}
+
+void Engine::clearInputs() {
+  for (auto &Input : mInputs)
+    releaseInput(Input.second);
+  mInputs.clear();
+}
+
+void Engine::takeOutput() {
+  mOut.flush();
+  mOutput = mStream.str();
+  mStream.str("");
+}
+
+const std::string &Engine::run() {
+  try {
+    mInterpreter.run(mInputs);
+  } catch (...) {
+    takeOutput();
+    throw;
+  }
+  takeOutput();
+  return mOutput;
+}
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "dragon/analysis/BigInt.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+typedef std::vector<std::uint32_t> LimbList;
+constexpr unsigned LimbBits = 32;
+
+void trim(LimbList &Limbs) {
+  while (!Limbs.empty() && Limbs.back() == 0)
+    Limbs.pop_back();
+}
+
+int compareMagnitude(const LimbList &Left, const LimbList &Right) {
+  if (Left.size() != Right.size())
+    return Left.size() < Right.size() ? -1 : 1;
+  for (auto Idx = Left.size(); Idx-- > 0;)
+    if (Left[Idx] != Right[Idx])
+      return Left[Idx] < Right[Idx] ? -1 : 1;
+  return 0;
+}
+
+LimbList addMagnitude(const LimbList &Left, const LimbList &Right) {
+  auto &Long = Left.size() >= Right.size() ? Left : Right;
+  auto &Short = Left.size() >= Right.size() ? Right : Left;
+  LimbList Res(Long.size() + 1);
+  std::uint64_t Carry = 0;
+  for (std::size_t Idx = 0; Idx < Long.size(); ++Idx) {
+    Carry += Long[Idx];
+    if (Idx < Short.size())
+      Carry += Short[Idx];
+    Res[Idx] = static_cast<std::uint32_t>(Carry);
+    Carry >>= LimbBits;
+  }
+  Res.back() = static_cast<std::uint32_t>(Carry);
+  trim(Res);
+  return Res;
+}
+
+// Left must not be less than Right.
+LimbList subMagnitude(const LimbList &Left, const LimbList &Right) {
+  LimbList Res(Left.size());
+  std::int64_t Borrow = 0;
+  for (std::size_t Idx = 0; Idx < Left.size(); ++Idx) {
+    std::int64_t Diff = std::int64_t(Left[Idx]) - Borrow -
+        (Idx < Right.size() ? std::int64_t(Right[Idx]) : 0);
+    Borrow = Diff < 0;
+    Res[Idx] = static_cast<std::uint32_t>(Diff + (Borrow << LimbBits));
+  }
+  assert(!Borrow && "Magnitude underflow!");
+  trim(Res);
+  return Res;
+}
+
+LimbList mulMagnitude(const LimbList &Left, const LimbList &Right) {
+  if (Left.empty() || Right.empty())
+    return {};
+  LimbList Res(Left.size() + Right.size());
+  for (std::size_t I = 0; I < Left.size(); ++I) {
+    std::uint64_t Carry = 0;
+    for (std::size_t J = 0; J < Right.size(); ++J) {
+      Carry += std::uint64_t(Left[I]) * Right[J] + Res[I + J];
+      Res[I + J] = static_cast<std::uint32_t>(Carry);
+      Carry >>= LimbBits;
+    }
+    Res[I + Right.size()] = static_cast<std::uint32_t>(Carry);
+  }
+  trim(Res);
+  return Res;
+}
+
+// Divides in place by a single limb and returns the remainder.
+std::uint32_t divSmall(LimbList &Limbs, std::uint32_t Divisor) {
+  std::uint64_t Rem = 0;
+  for (auto Idx = Limbs.size(); Idx-- > 0;) {
+    auto Cur = (Rem << LimbBits) | Limbs[Idx];
+    Limbs[Idx] = static_cast<std::uint32_t>(Cur / Divisor);
+    Rem = Cur % Divisor;
+  }
+  trim(Limbs);
+  return static_cast<std::uint32_t>(Rem);
+}
+
+LimbList shlMagnitude(const LimbList &Limbs, std::uint64_t Count) {
+  if (Limbs.empty())
+    return {};
+  auto Whole = Count / LimbBits;
+  unsigned Part = Count % LimbBits;
+  LimbList Res(Limbs.size() + Whole + 1);
+  for (std::size_t Idx = 0; Idx < Limbs.size(); ++Idx) {
+    std::uint64_t Cur = std::uint64_t(Limbs[Idx]) << Part;
+    Res[Idx + Whole] |= static_cast<std::uint32_t>(Cur);
+    Res[Idx + Whole + 1] |= static_cast<std::uint32_t>(Cur >> LimbBits);
+  }
+  trim(Res);
+  return Res;
+}
+
+LimbList shrMagnitude(const LimbList &Limbs, std::uint64_t Count) {
+  auto Whole = Count / LimbBits;
+  unsigned Part = Count % LimbBits;
+  if (Whole >= Limbs.size())
+    return {};
+  LimbList Res(Limbs.size() - Whole);
+  for (std::size_t Idx = 0; Idx < Res.size(); ++Idx) {
+    std::uint64_t Cur = Limbs[Idx + Whole];
+    if (Idx + Whole + 1 < Limbs.size())
+      Cur |= std::uint64_t(Limbs[Idx + Whole + 1]) << LimbBits;
+    Res[Idx] = static_cast<std::uint32_t>(Cur >> Part);
+  }
+  trim(Res);
+  return Res;
+}
+
+// Remainder of the magnitudes by long division (Knuth, algorithm D).
+LimbList remMagnitude(const LimbList &Left, const LimbList &Right) {
+  assert(!Right.empty() && "Division by zero!");
+  if (compareMagnitude(Left, Right) < 0)
+    return Left;
+  if (Right.size() == 1) {
+    auto Quot = Left;
+    LimbList Rem { divSmall(Quot, Right[0]) };
+    trim(Rem);
+    return Rem;
+  }
+  // Normalize so that the top limb of the divisor has its high bit set.
+  unsigned Shift = __builtin_clz(Right.back());
+  auto Num = shlMagnitude(Left, Shift);
+  auto Den = shlMagnitude(Right, Shift);
+  Num.resize(Left.size() + 1);
+  auto N = Den.size(), M = Num.size() - N;
+  std::uint64_t Base = std::uint64_t(1) << LimbBits;
+  for (auto J = M; J-- > 0;) {
+    std::uint64_t Top = (std::uint64_t(Num[J + N]) << LimbBits) |
+                        Num[J + N - 1];
+    std::uint64_t QHat = Top / Den[N - 1];
+    std::uint64_t RHat = Top % Den[N - 1];
+    while (QHat >= Base ||
+           QHat * Den[N - 2] > ((RHat << LimbBits) | Num[J + N - 2])) {
+      --QHat;
+      RHat += Den[N - 1];
+      if (RHat >= Base)
+        break;
+    }
+    // Subtract QHat times the divisor, add it back once if that overshot.
+    std::int64_t Borrow = 0;
+    std::uint64_t Carry = 0;
+    for (std::size_t I = 0; I < N; ++I) {
+      Carry += QHat * Den[I];
+      std::int64_t Diff = std::int64_t(Num[I + J]) - Borrow -
+                          std::int64_t(Carry & 0xffffffff);
+      Carry >>= LimbBits;
+      Borrow = Diff < 0;
+      Num[I + J] = static_cast<std::uint32_t>(Diff + (Borrow << LimbBits));
+    }
+    std::int64_t Diff = std::int64_t(Num[J + N]) - Borrow -
+                        std::int64_t(Carry);
+    Num[J + N] = static_cast<std::uint32_t>(Diff);
+    if (Diff < 0) {
+      std::uint64_t Sum = 0;
+      for (std::size_t I = 0; I < N; ++I) {
+        Sum += std::uint64_t(Num[I + J]) + Den[I];
+        Num[I + J] = static_cast<std::uint32_t>(Sum);
+        Sum >>= LimbBits;
+      }
+      Num[J + N] += static_cast<std::uint32_t>(Sum);
+    }
+  }
+  Num.resize(N);
+  trim(Num);
+  return shrMagnitude(Num, Shift);
+}
+
+} // namespace
+
+BigInt::BigInt(std::int64_t Int) : mNegative(Int < 0) {
+  auto Mag = mNegative ? 0 - static_cast<std::uint64_t>(Int) :
+                         static_cast<std::uint64_t>(Int);
+  mLimbs = { static_cast<std::uint32_t>(Mag),
+             static_cast<std::uint32_t>(Mag >> LimbBits) };
+  trim(mLimbs);
+}
+
+BigInt::BigInt(bool Negative, LimbList &&Limbs)
+    : mNegative(Negative), mLimbs(std::move(Limbs)) {
+  trim(mLimbs);
+  if (mLimbs.empty())
+    mNegative = false;
+}
+
+std::optional<std::int64_t> BigInt::toInt64() const {
+  if (mLimbs.size() > 2)
+    return std::nullopt;
+  std::uint64_t Mag = 0;
+  for (auto Idx = mLimbs.size(); Idx-- > 0;)
+    Mag = (Mag << LimbBits) | mLimbs[Idx];
+  constexpr auto Max = std::uint64_t(std::numeric_limits<std::int64_t>::max());
+  if (Mag > Max + mNegative)
+    return std::nullopt;
+  return mNegative ? static_cast<std::int64_t>(0 - Mag) :
+                     static_cast<std::int64_t>(Mag);
+}
+
+double BigInt::toDouble() const {
+  double Res = 0;
+  for (auto Idx = mLimbs.size(); Idx-- > 0;)
+    Res = Res * 4294967296.0 + mLimbs[Idx];
+  return mNegative ? -Res : Res;
+}
+
+std::string BigInt::toString() const {
+  if (mLimbs.empty())
+    return "0";
+  // Nine decimal digits at a time, least significant first.
+  std::vector<std::uint32_t> Chunks;
+  auto Limbs = mLimbs;
+  while (!Limbs.empty())
+    Chunks.push_back(divSmall(Limbs, 1000000000));
+  std::string Res = mNegative ? "-" : "";
+  Res += std::to_string(Chunks.back());
+  for (auto Idx = Chunks.size() - 1; Idx-- > 0;) {
+    auto Chunk = std::to_string(Chunks[Idx]);
+    Res.append(9 - Chunk.size(), '0');
+    Res += Chunk;
+  }
+  return Res;
+}
+
+int BigInt::compare(const BigInt &Other) const {
+  if (mNegative != Other.mNegative)
+    return mNegative ? -1 : 1;
+  auto Cmp = compareMagnitude(mLimbs, Other.mLimbs);
+  return mNegative ? -Cmp : Cmp;
+}
+
+BigInt BigInt::operator-() const {
+  return BigInt(!mNegative, LimbList(mLimbs));
+}
+
+BigInt BigInt::operator+(const BigInt &Other) const {
+  if (mNegative == Other.mNegative)
+    return BigInt(mNegative, addMagnitude(mLimbs, Other.mLimbs));
+  if (compareMagnitude(mLimbs, Other.mLimbs) >= 0)
+    return BigInt(mNegative, subMagnitude(mLimbs, Other.mLimbs));
+  return BigInt(Other.mNegative, subMagnitude(Other.mLimbs, mLimbs));
+}
+
+BigInt BigInt::operator-(const BigInt &Other) const { return *this + -Other; }
+
+BigInt BigInt::operator*(const BigInt &Other) const {
+  return BigInt(mNegative != Other.mNegative,
+                mulMagnitude(mLimbs, Other.mLimbs));
+}
+
+BigInt BigInt::operator%(const BigInt &Other) const {
+  return BigInt(mNegative, remMagnitude(mLimbs, Other.mLimbs));
+}
+
+BigInt BigInt::operator&(const BigInt &Other) const {
+  return bitwise(Other, BitOp::AND);
+}
+
+BigInt BigInt::operator|(const BigInt &Other) const {
+  return bitwise(Other, BitOp::OR);
+}
+
+BigInt BigInt::operator^(const BigInt &Other) const {
+  return bitwise(Other, BitOp::XOR);
+}
+
+BigInt BigInt::shl(std::uint64_t Count) const {
+  return BigInt(mNegative, shlMagnitude(mLimbs, Count));
+}
+
+BigInt BigInt::shr(std::uint64_t Count) const {
+  if (!mNegative)
+    return BigInt(false, shrMagnitude(mLimbs, Count));
+  // -((|x| - 1) >> Count) - 1 rounds toward negative infinity.
+  auto Mag = subMagnitude(mLimbs, { 1 });
+  auto Shifted = shrMagnitude(Mag, Count);
+  return BigInt(true, addMagnitude(Shifted, { 1 }));
+}
+
+// Limbs of the two's complement form, sign extended to Size limbs.
+BigInt::LimbList BigInt::toTwosComplement(std::size_t Size) const {
+  LimbList Res(mLimbs);
+  Res.resize(Size);
+  if (!mNegative)
+    return Res;
+  std::uint64_t Carry = 1;
+  for (auto &Limb : Res) {
+    Carry += static_cast<std::uint32_t>(~Limb);
+    Limb = static_cast<std::uint32_t>(Carry);
+    Carry >>= LimbBits;
+  }
+  return Res;
+}
+
+BigInt BigInt::bitwise(const BigInt &Other, BitOp Op) const {
+  // One extra limb keeps the sign bit of both operands.
+  auto Size = std::max(mLimbs.size(), Other.mLimbs.size()) + 1;
+  auto Res = toTwosComplement(Size);
+  auto Right = Other.toTwosComplement(Size);
+  for (std::size_t Idx = 0; Idx < Size; ++Idx) {
+    switch (Op) {
+    case BitOp::AND: Res[Idx] &= Right[Idx]; break;
+    case BitOp::OR: Res[Idx] |= Right[Idx]; break;
+    case BitOp::XOR: Res[Idx] ^= Right[Idx]; break;
+    }
+  }
+  bool Negative = Res.back() >> (LimbBits - 1);
+  if (Negative) {
+    std::uint64_t Carry = 1;
+    for (auto &Limb : Res) {
+      Carry += static_cast<std::uint32_t>(~Limb);
+      Limb = static_cast<std::uint32_t>(Carry);
+      Carry >>= LimbBits;
+    }
+  }
+  return BigInt(Negative, std::move(Res));
+}
+
+void BigInt::writeBytes(char *Out) const {
+  *Out = mNegative;
+  std::memcpy(Out + 1, mLimbs.data(), mLimbs.size() * 4);
+}
+
+BigInt BigInt::readBytes(std::string_view Bytes) {
+  assert(!Bytes.empty() && (Bytes.size() - 1) % 4 == 0 &&
+         "Malformed big integer!");
+  LimbList Limbs((Bytes.size() - 1) / 4);
+  std::memcpy(Limbs.data(), Bytes.data() + 1, Limbs.size() * 4);
+  return BigInt(Bytes[0] != 0, std::move(Limbs));
+}
\ No newline at end of file
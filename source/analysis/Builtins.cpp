@@ -0,0 +1,393 @@
+#include "dragon/analysis/Builtins.h"
+#include "dragon/analysis/Dict.h"
+#include "dragon/analysis/Interpreter.h"
+#include "dragon/analysis/NumericKernels.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+// Chosen once for the CPU the program runs on.
+const NumericKernels &getKernels() {
+  static const NumericKernels Kernels;
+  return Kernels;
+}
+
+const Value &expectArray(const Value &Arg, std::string_view Name,
+                         const PosInfo &PI) {
+  if (!Arg.isArray())
+    throw InterpreterException("Array expected for `" + std::string(Name) +
+                               "` at " + Token::posToString(PI));
+  return Arg;
+}
+
+void expectSameLength(const Value &X, const Value &Y, std::string_view Name,
+                      const PosInfo &PI) {
+  if (X.getArrayLength() != Y.getArrayLength())
+    throw InterpreterException("Array lengths differ for `" +
+        std::string(Name) + "` at " + Token::posToString(PI));
+}
+
+// Number argument of a math builtin, a big int is taken as a float.
+double expectNumber(const Value &Arg, std::string_view Name,
+                    const PosInfo &PI) {
+  if (Arg.isNumber())
+    return Arg.getNumber();
+  if (Arg.isBigInt())
+    return Arg.getBigInt().toDouble();
+  throw InterpreterException("Number expected for `" + std::string(Name) +
+                             "` at " + Token::posToString(PI));
+}
+
+BigInt toBigInt(const Value &Int) {
+  return Int.isInt() ? BigInt(Int.getInt()) : Int.getBigInt();
+}
+
+[[noreturn]] void throwOverflow(std::string_view Name, const PosInfo &PI) {
+  throw InterpreterException("Integer overflow in `" + std::string(Name) +
+                             "` at " + Token::posToString(PI));
+}
+
+// Elements of an int array converted into a new float array, the elements
+// of a float array as they are.
+const double *getFloats(Interpreter &I, const Value &Array,
+                        const PosInfo &PI) {
+  if (Array.getElementType() == Value::FLOAT)
+    return Array.getFloats();
+  auto Res = I.createArray(Value::FLOAT, Array.getArrayLength(), PI);
+  std::copy_n(Array.getInts(), Array.getArrayLength(), Res.getFloats());
+  return Res.getFloats();
+}
+
+// Exact sum of products of the ints, used once the 64-bit one overflows.
+Value sumExactly(Interpreter &I, const std::int64_t *X,
+                 const std::int64_t *Y, std::size_t N) {
+  BigInt Sum;
+  for (std::size_t Idx = 0; Idx < N; ++Idx)
+    Sum = Sum + (Y ? BigInt(X[Idx]) * BigInt(Y[Idx]) : BigInt(X[Idx]));
+  return makeInteger(Sum, I.getArena());
+}
+
+// `fill(a, x)` sets every element of a to x and returns a.
+Value fill(Interpreter &, const Value *Args, const PosInfo &PI) {
+  auto &Array = expectArray(Args[0], "fill", PI);
+  auto &Elem = Args[1];
+  std::uint64_t *Data;
+  std::uint64_t Bits;
+  if (Array.getElementType() == Value::FLOAT && Elem.isNumber()) {
+    auto Float = Elem.getNumber();
+    std::memcpy(&Bits, &Float, sizeof(Bits));
+    Data = reinterpret_cast<std::uint64_t *>(Array.getFloats());
+  } else if (Array.getElementType() == Value::INTEGER && Elem.isInt()) {
+    Bits = Elem.getInt();
+    Data = reinterpret_cast<std::uint64_t *>(Array.getInts());
+  } else if (Elem.isFloat()) {
+    throw InterpreterException("Float stored into an int array at " +
+                               Token::posToString(PI));
+  } else if (Elem.isBigInt()) {
+    throw InterpreterException("Integer is too large for an array at " +
+                               Token::posToString(PI));
+  } else {
+    throw InterpreterException("Array elements must be numbers at " +
+                               Token::posToString(PI));
+  }
+  getKernels().fill(Data, Array.getArrayLength(), Bits);
+  return Array;
+}
+
+// `sum(a)` is an int for an int array, a big one if it has to be.
+Value sum(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  auto &Array = expectArray(Args[0], "sum", PI);
+  auto N = Array.getArrayLength();
+  if (Array.getElementType() == Value::FLOAT)
+    return Value(getKernels().sum(Array.getFloats(), N));
+  std::int64_t Res;
+  if (getKernels().sum(Array.getInts(), N, Res))
+    return Value(Res);
+  return sumExactly(I, Array.getInts(), nullptr, N);
+}
+
+// `min(a)` and `max(a)` fail on an empty array.
+template <bool IsMax>
+Value extremum(Interpreter &, const Value *Args, const PosInfo &PI) {
+  constexpr std::string_view Name = IsMax ? "max" : "min";
+  auto &Array = expectArray(Args[0], Name, PI);
+  auto N = Array.getArrayLength();
+  if (!N)
+    throw InterpreterException("Empty array for `" + std::string(Name) +
+                               "` at " + Token::posToString(PI));
+  auto &K = getKernels();
+  if (Array.getElementType() == Value::FLOAT)
+    return Value(IsMax ? K.max(Array.getFloats(), N) :
+                         K.min(Array.getFloats(), N));
+  return Value(IsMax ? K.max(Array.getInts(), N) : K.min(Array.getInts(), N));
+}
+
+// `dot(a, b)` is an int only if both arrays hold ints.
+Value dot(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  auto &X = expectArray(Args[0], "dot", PI);
+  auto &Y = expectArray(Args[1], "dot", PI);
+  expectSameLength(X, Y, "dot", PI);
+  auto N = X.getArrayLength();
+  if (X.getElementType() == Value::INTEGER &&
+      Y.getElementType() == Value::INTEGER) {
+    std::int64_t Res;
+    if (getKernels().dot(X.getInts(), Y.getInts(), N, Res))
+      return Value(Res);
+    return sumExactly(I, X.getInts(), Y.getInts(), N);
+  }
+  return Value(getKernels().dot(getFloats(I, X, PI), getFloats(I, Y, PI),
+                                N));
+}
+
+// `axpy(alpha, x, y)` adds alpha * x to y in place and returns y. An int
+// array takes only int operands; it is left partly updated if an element
+// overflows.
+Value axpy(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  auto &Alpha = Args[0];
+  auto &X = expectArray(Args[1], "axpy", PI);
+  auto &Y = expectArray(Args[2], "axpy", PI);
+  expectSameLength(X, Y, "axpy", PI);
+  if (!Alpha.isNumber())
+    throw InterpreterException("Number expected for `axpy` at " +
+                               Token::posToString(PI));
+  auto N = X.getArrayLength();
+  if (Y.getElementType() == Value::FLOAT) {
+    getKernels().axpy(Alpha.getNumber(), getFloats(I, X, PI), Y.getFloats(),
+                      N);
+  } else if (Alpha.isFloat() || X.getElementType() == Value::FLOAT) {
+    throw InterpreterException("Float stored into an int array at " +
+                               Token::posToString(PI));
+  } else if (!getKernels().axpy(Alpha.getInt(), X.getInts(), Y.getInts(),
+                                N)) {
+    throwOverflow("axpy", PI);
+  }
+  return Y;
+}
+
+// `add(a, b)` and `mul(a, b)` return a new array of the elementwise results,
+// which holds floats if either array does.
+template <bool IsMul>
+Value elementwise(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  constexpr std::string_view Name = IsMul ? "mul" : "add";
+  auto &X = expectArray(Args[0], Name, PI);
+  auto &Y = expectArray(Args[1], Name, PI);
+  expectSameLength(X, Y, Name, PI);
+  auto N = X.getArrayLength();
+  auto &K = getKernels();
+  if (X.getElementType() == Value::INTEGER &&
+      Y.getElementType() == Value::INTEGER) {
+    auto Res = I.createArray(Value::INTEGER, N, PI);
+    if (!(IsMul ? K.mul(X.getInts(), Y.getInts(), Res.getInts(), N) :
+                  K.add(X.getInts(), Y.getInts(), Res.getInts(), N)))
+      throwOverflow(Name, PI);
+    return Res;
+  }
+  auto XFloats = getFloats(I, X, PI);
+  auto YFloats = getFloats(I, Y, PI);
+  auto Res = I.createArray(Value::FLOAT, N, PI);
+  if (IsMul)
+    K.mul(XFloats, YFloats, Res.getFloats(), N);
+  else
+    K.add(XFloats, YFloats, Res.getFloats(), N);
+  return Res;
+}
+
+// `prefix_sum(a)` returns a new array of the running sums of a.
+Value prefixSum(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  auto &Array = expectArray(Args[0], "prefix_sum", PI);
+  auto N = Array.getArrayLength();
+  auto Res = I.createArray(Array.getElementType(), N, PI);
+  if (Array.getElementType() == Value::FLOAT)
+    getKernels().prefixSum(Array.getFloats(), Res.getFloats(), N);
+  else if (!getKernels().prefixSum(Array.getInts(), Res.getInts(), N))
+    throwOverflow("prefix_sum", PI);
+  return Res;
+}
+
+// `dict()` returns a new empty dict.
+Value dict(Interpreter &I, const Value *, const PosInfo &) {
+  return I.createDict();
+}
+
+// `get(d, k, x)` returns the value of k in d, or x if d has no such key.
+Value get(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  if (!Args[0].isDict())
+    throw InterpreterException("Dict expected for `get` at " +
+                               Token::posToString(PI));
+  auto &Key = Args[1];
+  if (!Dict::isKey(Key))
+    throw InterpreterException("Dict keys must be ints or strings at " +
+                               Token::posToString(PI));
+  if (auto Found = Args[0].getDict().find(Key, Dict::hash(Key)))
+    return I.load(*Found);
+  return Args[2];
+}
+
+// `sqrt(x)` is a float, x must not be negative.
+Value squareRoot(Interpreter &, const Value *Args, const PosInfo &PI) {
+  auto X = expectNumber(Args[0], "sqrt", PI);
+  if (X < 0)
+    throw InterpreterException("Negative number for `sqrt` at " +
+                               Token::posToString(PI));
+  return Value(std::sqrt(X));
+}
+
+// Largest result of `pow` on ints, in bits.
+constexpr double MaxPowerBits = 1 << 20;
+
+// Exact power of ints, the exponent is not negative.
+Value intPower(Interpreter &I, const Value &Base, const Value &Exp,
+               const PosInfo &PI) {
+  if (Base.isInt() && Exp.isInt()) {
+    std::int64_t Res = 1, Square = Base.getInt();
+    bool Overflow = false;
+    for (auto E = Exp.getInt(); E; E >>= 1) {
+      if (E & 1)
+        Overflow |= __builtin_mul_overflow(Res, Square, &Res);
+      if (E > 1)
+        Overflow |= __builtin_mul_overflow(Square, Square, &Square);
+    }
+    if (!Overflow)
+      return Value(Res);
+  }
+  auto Square = toBigInt(Base);
+  // Powers of 0, 1 and -1 stay small whatever the exponent.
+  if (Square.isZero() || Square.compare(BigInt(1)) == 0)
+    return Exp.isInt() && Exp.getInt() == 0 ? Value(std::int64_t(1)) : Base;
+  if (Square.compare(BigInt(-1)) == 0) {
+    bool Odd = Exp.isInt() ? Exp.getInt() & 1 :
+                             !(Exp.getBigInt() % BigInt(2)).isZero();
+    return Value(std::int64_t(Odd ? -1 : 1));
+  }
+  // Multiplication is quadratic, a result of MaxPowerBits already takes
+  // about half a second.
+  if (!Exp.isInt() ||
+      std::log2(std::fabs(Square.toDouble())) * Exp.getInt() > MaxPowerBits)
+    throw InterpreterException("Integer is too large for `pow` at " +
+                               Token::posToString(PI));
+  BigInt Res(1);
+  for (auto E = Exp.getInt(); E; E >>= 1) {
+    if (E & 1)
+      Res = Res * Square;
+    if (E > 1)
+      Square = Square * Square;
+  }
+  return makeInteger(Res, I.getArena());
+}
+
+// `pow(x, y)` of ints is an exact int unless y is negative, anything else is
+// a float.
+Value power(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  auto &Base = Args[0], &Exp = Args[1];
+  bool IsIntBase = Base.isInt() || Base.isBigInt();
+  if (IsIntBase && Exp.isInt() && Exp.getInt() >= 0)
+    return intPower(I, Base, Exp, PI);
+  if (IsIntBase && Exp.isBigInt() && !Exp.getBigInt().isNegative())
+    return intPower(I, Base, Exp, PI);
+  return Value(std::pow(expectNumber(Base, "pow", PI),
+                        expectNumber(Exp, "pow", PI)));
+}
+
+// `floor(x)` is the greatest int not above x, ints are returned as they are.
+Value roundDown(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  auto &X = Args[0];
+  if (X.isInt() || X.isBigInt())
+    return X;
+  auto Floor = std::floor(expectNumber(X, "floor", PI));
+  if (!std::isfinite(Floor))
+    throw InterpreterException("Finite number expected for `floor` at " +
+                               Token::posToString(PI));
+  if (Floor >= -0x1p63 && Floor < 0x1p63)
+    return Value(static_cast<std::int64_t>(Floor));
+  // Larger floats are whole numbers, their 53 bits of mantissa are shifted
+  // into place.
+  int Exponent;
+  auto Mantissa = std::frexp(Floor, &Exponent);
+  BigInt Int(static_cast<std::int64_t>(std::ldexp(Mantissa, 53)));
+  return makeInteger(Int.shl(Exponent - 53), I.getArena());
+}
+
+// `abs(x)` keeps the type of x.
+Value absolute(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  auto &X = Args[0];
+  if (X.isInt() && X.getInt() != std::numeric_limits<std::int64_t>::min())
+    return Value(X.getInt() < 0 ? -X.getInt() : X.getInt());
+  if (X.isInt() || X.isBigInt()) {
+    auto Int = toBigInt(X);
+    return makeInteger(Int.isNegative() ? -Int : Int, I.getArena());
+  }
+  return Value(std::fabs(expectNumber(X, "abs", PI)));
+}
+
+// `clock_ns()` reads a monotonic clock in nanoseconds, only the difference
+// of two readings means anything.
+Value clockNs(Interpreter &, const Value *, const PosInfo &) {
+  auto Now = std::chrono::steady_clock::now().time_since_epoch();
+  return Value(static_cast<std::int64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Now).count()));
+}
+
+// `random()` is a float in [0, 1).
+Value randomFloat(Interpreter &I, const Value *, const PosInfo &) {
+  return Value(I.getRandom().nextDouble());
+}
+
+// `random_int(n)` is an int in [0, n).
+Value randomInt(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  if (!Args[0].isInt() || Args[0].getInt() <= 0)
+    throw InterpreterException("Positive int expected for `random_int` at " +
+                               Token::posToString(PI));
+  return Value(static_cast<std::int64_t>(
+      I.getRandom().nextBelow(Args[0].getInt())));
+}
+
+// `seed(n)` restarts the random numbers from the int n and returns it.
+Value seed(Interpreter &I, const Value *Args, const PosInfo &PI) {
+  if (!Args[0].isInt())
+    throw InterpreterException("Int expected for `seed` at " +
+                               Token::posToString(PI));
+  I.getRandom().seed(Args[0].getInt());
+  return Args[0];
+}
+
+// Compiled program caches refer to builtins by index, new ones go at the end.
+const std::array<Builtin, 19> Builtins = {{
+  { "fill", 2, fill },
+  { "sum", 1, sum },
+  { "min", 1, extremum<false> },
+  { "max", 1, extremum<true> },
+  { "dot", 2, dot },
+  { "axpy", 3, axpy },
+  { "add", 2, elementwise<false> },
+  { "mul", 2, elementwise<true> },
+  { "prefix_sum", 1, prefixSum },
+  { "dict", 0, dict },
+  { "get", 3, get },
+  { "sqrt", 1, squareRoot },
+  { "pow", 2, power },
+  { "floor", 1, roundDown },
+  { "abs", 1, absolute },
+  { "clock_ns", 0, clockNs },
+  { "random", 0, randomFloat },
+  { "random_int", 1, randomInt },
+  { "seed", 1, seed }
+}};
+} // namespace
+
+std::size_t getBuiltinCount() { return Builtins.size(); }
+
+const Builtin &getBuiltin(std::size_t Idx) {
+  assert(Idx < Builtins.size() && "Unknown builtin!");
+  return Builtins[Idx];
+}
+
+std::optional<std::size_t> findBuiltin(std::string_view Name) {
+  for (std::size_t Idx = 0; Idx < Builtins.size(); ++Idx)
+    if (Builtins[Idx].Name == Name)
+      return Idx;
+  return std::nullopt;
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "dragon/analysis/Bytecode.h"
+#include "dragon/analysis/Builtins.h"
+
+const char *opcodeToString(Opcode Op) {
+  switch (Op) {
+  case Opcode::PUSH_CONST: return "push_const";
+  case Opcode::LOAD: return "load";
+  case Opcode::STORE: return "store";
+  case Opcode::LOAD_GLOBAL: return "load_global";
+  case Opcode::STORE_GLOBAL: return "store_global";
+  case Opcode::POP: return "pop";
+  case Opcode::GLOBAL: return "global";
+  case Opcode::CALL: return "call";
+  case Opcode::TAIL_CALL: return "tail_call";
+  case Opcode::CALL_NATIVE: return "call_native";
+  case Opcode::RET: return "ret";
+  case Opcode::RET_VOID: return "ret_void";
+  case Opcode::JMP: return "jmp";
+  case Opcode::JMP_IF: return "jmp_if";
+  case Opcode::JMP_IF_FALSE: return "jmp_if_false";
+  case Opcode::MAKE_ARRAY: return "make_array";
+  case Opcode::LOAD_INDEX: return "load_index";
+  case Opcode::STORE_INDEX: return "store_index";
+  case Opcode::DELETE_INDEX: return "delete_index";
+  case Opcode::SLICE: return "slice";
+  case Opcode::FOR_PREP: return "for_prep";
+  case Opcode::FOR_NEXT: return "for_next";
+  case Opcode::INC_LOCAL: return "inc_local";
+  case Opcode::CMP_JMP_LOCAL: return "cmp_jmp_local";
+  case Opcode::CMP_JMP_CONST: return "cmp_jmp_const";
+  case Opcode::BINARY_LOCAL: return "binary_local";
+  case Opcode::BINARY_CONST: return "binary_const";
+  case Opcode::INDEX_LOCAL: return "index_local";
+  case Opcode::STORE_INDEX_LOCAL: return "store_index_local";
+  case Opcode::POS: return "pos";
+  case Opcode::NEG: return "neg";
+  case Opcode::NOT: return "not";
+  case Opcode::LEN: return "len";
+  case Opcode::PRINT: return "print";
+  case Opcode::PRINTLN: return "println";
+  case Opcode::ADD: return "add";
+  case Opcode::SUB: return "sub";
+  case Opcode::MUL: return "mul";
+  case Opcode::DIV: return "div";
+  case Opcode::MOD: return "mod";
+  case Opcode::SHL: return "shl";
+  case Opcode::SHR: return "shr";
+  case Opcode::BIT_AND: return "bit_and";
+  case Opcode::BIT_OR: return "bit_or";
+  case Opcode::BIT_XOR: return "bit_xor";
+  case Opcode::AND: return "and";
+  case Opcode::OR: return "or";
+  case Opcode::EQ: return "eq";
+  case Opcode::NE: return "ne";
+  case Opcode::LT: return "lt";
+  case Opcode::LE: return "le";
+  case Opcode::GT: return "gt";
+  case Opcode::GE: return "ge";
+  case Opcode::IN: return "in";
+  case Opcode::ADD_INT: return "add_int";
+  case Opcode::SUB_INT: return "sub_int";
+  case Opcode::MUL_INT: return "mul_int";
+  case Opcode::MOD_INT: return "mod_int";
+  case Opcode::EQ_INT: return "eq_int";
+  case Opcode::NE_INT: return "ne_int";
+  case Opcode::LT_INT: return "lt_int";
+  case Opcode::LE_INT: return "le_int";
+  case Opcode::GT_INT: return "gt_int";
+  case Opcode::GE_INT: return "ge_int";
+  case Opcode::ADD_FLOAT: return "add_float";
+  case Opcode::SUB_FLOAT: return "sub_float";
+  case Opcode::MUL_FLOAT: return "mul_float";
+  case Opcode::DIV_FLOAT: return "div_float";
+  case Opcode::LT_FLOAT: return "lt_float";
+  case Opcode::LE_FLOAT: return "le_float";
+  case Opcode::GT_FLOAT: return "gt_float";
+  case Opcode::GE_FLOAT: return "ge_float";
+  }
+  return "<unknown opcode>";
+}
+
+std::optional<Opcode> getQuickenedOpcode(Opcode Op, Value::Type Left,
+                                         Value::Type Right) {
+  if (Left == Value::INTEGER && Right == Value::INTEGER) {
+    switch (Op) {
+    case Opcode::ADD: return Opcode::ADD_INT;
+    case Opcode::SUB: return Opcode::SUB_INT;
+    case Opcode::MUL: return Opcode::MUL_INT;
+    case Opcode::MOD: return Opcode::MOD_INT;
+    case Opcode::EQ: return Opcode::EQ_INT;
+    case Opcode::NE: return Opcode::NE_INT;
+    case Opcode::LT: return Opcode::LT_INT;
+    case Opcode::LE: return Opcode::LE_INT;
+    case Opcode::GT: return Opcode::GT_INT;
+    case Opcode::GE: return Opcode::GE_INT;
+    default: return std::nullopt;
+    }
+  }
+  bool LeftNum = Left == Value::INTEGER || Left == Value::FLOAT;
+  bool RightNum = Right == Value::INTEGER || Right == Value::FLOAT;
+  if (!LeftNum || !RightNum)
+    return std::nullopt;
+  switch (Op) {
+  case Opcode::ADD: return Opcode::ADD_FLOAT;
+  case Opcode::SUB: return Opcode::SUB_FLOAT;
+  case Opcode::MUL: return Opcode::MUL_FLOAT;
+  case Opcode::DIV: return Opcode::DIV_FLOAT;
+  case Opcode::LT: return Opcode::LT_FLOAT;
+  case Opcode::LE: return Opcode::LE_FLOAT;
+  case Opcode::GT: return Opcode::GT_FLOAT;
+  case Opcode::GE: return Opcode::GE_FLOAT;
+  default: return std::nullopt;
+  }
+}
+
+Opcode getGenericOpcode(Opcode Op) {
+  switch (Op) {
+  case Opcode::ADD_INT:
+  case Opcode::ADD_FLOAT: return Opcode::ADD;
+  case Opcode::SUB_INT:
+  case Opcode::SUB_FLOAT: return Opcode::SUB;
+  case Opcode::MUL_INT:
+  case Opcode::MUL_FLOAT: return Opcode::MUL;
+  case Opcode::DIV_FLOAT: return Opcode::DIV;
+  case Opcode::MOD_INT: return Opcode::MOD;
+  case Opcode::EQ_INT: return Opcode::EQ;
+  case Opcode::NE_INT: return Opcode::NE;
+  case Opcode::LT_INT:
+  case Opcode::LT_FLOAT: return Opcode::LT;
+  case Opcode::LE_INT:
+  case Opcode::LE_FLOAT: return Opcode::LE;
+  case Opcode::GT_INT:
+  case Opcode::GT_FLOAT: return Opcode::GT;
+  case Opcode::GE_INT:
+  case Opcode::GE_FLOAT: return Opcode::GE;
+  default: return Op;
+  }
+}
+
+std::uint32_t CompiledFunction::addConstant(const Constant *Const) {
+  switch (Const->getTokenKind()) {
+  case TokenKind::INTEGER:
+    return addConstant(Value(cast<Integer>(Const)->getValue()));
+  case TokenKind::FLOAT:
+    return addConstant(Value(cast<Float>(Const)->getValue()));
+  case TokenKind::BOOLEAN:
+    return addConstant(Value(cast<Boolean>(Const)->getValue()));
+  case TokenKind::STRING:
+    return addString(cast<String>(Const)->getValue());
+  default:
+    assert(0 && "Unknown kind of constant!");
+    return 0;
+  }
+}
+
+std::uint32_t CompiledFunction::addConstant(const Value &Val) {
+  if (Val.isString())
+    return addString(Val.getString());
+  mConstants.push_back(Val);
+  return mConstants.size() - 1;
+}
+
+std::uint32_t CompiledFunction::addString(std::string_view Str) {
+  // Short strings live in the value, there is nothing to share.
+  if (Str.size() <= Value::MaxInlineLength) {
+    mConstants.push_back(Value::makeInline(Str));
+    return mConstants.size() - 1;
+  }
+  auto It = mStringIndex.find(Str);
+  if (It != mStringIndex.end())
+    return It->second;
+  auto &Buf = mStrings.emplace_back(
+      new char[StringObject::getAllocSize(Str.size())]);
+  auto Obj = StringObject::create(Buf.get(), Str, StringObject::Static);
+  mConstants.emplace_back(Obj);
+  mStringIndex.emplace(Obj->getView(), mConstants.size() - 1);
+  return mConstants.size() - 1;
+}
+
+void CompiledFunction::dump() const {
+  dbgs() << "Function `" << mName << "`:\n";
+  auto MaxNumLength = std::to_string(mCode.size()).size();
+  for (std::size_t PC = 0; PC < mCode.size(); ++PC) {
+    auto &I = mCode[PC];
+    auto NumLength = std::to_string(PC).size();
+    std::string Space(MaxNumLength - NumLength, ' ');
+    dbgs() << Space << PC << "| " << opcodeToString(I.Op);
+    switch (I.Op) {
+    case Opcode::PUSH_CONST:
+      dbgs() << " " << mConstants[I.A].toString();
+      break;
+    case Opcode::LOAD:
+    case Opcode::STORE:
+      dbgs() << " " << I.A << " (" << mLocals[I.A] << ")";
+      break;
+    case Opcode::LOAD_GLOBAL:
+    case Opcode::STORE_GLOBAL:
+    case Opcode::GLOBAL:
+      dbgs() << " #" << I.A;
+      break;
+    case Opcode::CALL:
+      dbgs() << " #" << I.A << (I.B ? "" : " (discard)");
+      break;
+    case Opcode::TAIL_CALL:
+      dbgs() << " #" << I.A;
+      break;
+    case Opcode::CALL_NATIVE:
+      dbgs() << " " << getBuiltin(I.A).Name;
+      break;
+    case Opcode::JMP:
+    case Opcode::JMP_IF:
+    case Opcode::JMP_IF_FALSE:
+    case Opcode::MAKE_ARRAY:
+      dbgs() << " " << I.A;
+      break;
+    case Opcode::FOR_PREP:
+      dbgs() << " " << I.A << " (" << mLocals[I.A] << ")";
+      break;
+    case Opcode::FOR_NEXT:
+      dbgs() << " " << I.A << ", " << I.B << " (" << mLocals[I.B] << ")";
+      break;
+    case Opcode::CMP_JMP_LOCAL:
+    case Opcode::BINARY_LOCAL:
+    case Opcode::INDEX_LOCAL:
+    case Opcode::STORE_INDEX_LOCAL:
+      dbgs() << " " << I.A << " (" << mLocals[I.A] << "), " << I.B << " (" <<
+          mLocals[I.B] << ")";
+      break;
+    case Opcode::INC_LOCAL:
+    case Opcode::CMP_JMP_CONST:
+    case Opcode::BINARY_CONST:
+      dbgs() << " " << I.A << " (" << mLocals[I.A] << "), " <<
+          mConstants[I.B].toString();
+      break;
+    default:
+      break;
+    }
+    dbgs() << "\n";
+  }
+  dbgs() << "\n";
+}
\ No newline at end of file
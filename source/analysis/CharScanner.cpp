@@ -0,0 +1,253 @@
+#include "dragon/analysis/CharScanner.h"
+#include "dragon/Common.h"
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+ #define DRAGON_SCAN_X86
+ #include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr auto makeClasses() {
+  std::array<std::uint8_t, 256> Classes {};
+  for (char Char : std::string_view(" \t\n\v\f\r"))
+    Classes[static_cast<unsigned char>(Char)] |= CharScanner::SPACE;
+  for (int Char = '0'; Char <= '9'; ++Char)
+    Classes[Char] |= CharScanner::DIGIT | CharScanner::WORD;
+  for (int Char = 'a'; Char <= 'z'; ++Char)
+    Classes[Char] |= CharScanner::WORD;
+  for (int Char = 'A'; Char <= 'Z'; ++Char)
+    Classes[Char] |= CharScanner::WORD;
+  Classes['_'] |= CharScanner::WORD;
+  return Classes;
+}
+
+constexpr auto Classes = makeClasses();
+
+/* Scalar kernels, also used for the tails of the vector ones */
+
+inline const char *skipClass(const char *Ptr, const char *End,
+                             CharScanner::CharClass Class) {
+  while (Ptr != End && (Classes[static_cast<unsigned char>(*Ptr)] & Class))
+    ++Ptr;
+  return Ptr;
+}
+
+inline const char *findChar(const char *Ptr, const char *End, char Char) {
+  while (Ptr != End && *Ptr != Char)
+    ++Ptr;
+  return Ptr;
+}
+
+const char *skipSpacesScalar(const char *Ptr, const char *End) {
+  return skipClass(Ptr, End, CharScanner::SPACE);
+}
+
+const char *skipWordScalar(const char *Ptr, const char *End) {
+  return skipClass(Ptr, End, CharScanner::WORD);
+}
+
+const char *skipDigitsScalar(const char *Ptr, const char *End) {
+  return skipClass(Ptr, End, CharScanner::DIGIT);
+}
+
+const char *findScalar(const char *Ptr, const char *End, char Char) {
+  return findChar(Ptr, End, Char);
+}
+
+#ifdef DRAGON_SCAN_X86
+
+/* SSE2 kernels. Bytes above 0x7f compare as negative and so never fall in
+   any of the ranges below. */
+
+inline __m128i inRange128(__m128i X, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(X, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmplt_epi8(X, _mm_set1_epi8(Hi + 1)));
+}
+
+inline __m128i isSpace128(__m128i X) {
+  return _mm_or_si128(_mm_cmpeq_epi8(X, _mm_set1_epi8(' ')),
+                      inRange128(X, '\t', '\r'));
+}
+
+inline __m128i isDigit128(__m128i X) { return inRange128(X, '0', '9'); }
+
+inline __m128i isWord128(__m128i X) {
+  auto Lower = _mm_or_si128(X, _mm_set1_epi8(0x20));
+  return _mm_or_si128(_mm_or_si128(isDigit128(X), inRange128(Lower, 'a', 'z')),
+                      _mm_cmpeq_epi8(X, _mm_set1_epi8('_')));
+}
+
+// Offset of the first byte that is not in the mask, or 16.
+inline unsigned firstMiss128(__m128i Mask) {
+  unsigned Bits = ~_mm_movemask_epi8(Mask) & 0xffff;
+  return Bits ? __builtin_ctz(Bits) : 16;
+}
+
+// Most runs in real code are short, so the first character is checked
+// before any vector is loaded.
+#define DRAGON_SSE2_SKIP(Name, Classify, Class)                              \
+  const char *Name(const char *Ptr, const char *End) {                       \
+    if (Ptr == End || !(Classes[static_cast<unsigned char>(*Ptr)] & Class))  \
+      return Ptr;                                                            \
+    for (; End - Ptr >= 16; Ptr += 16) {                                     \
+      auto X = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));      \
+      if (auto Off = firstMiss128(Classify(X)); Off != 16)                   \
+        return Ptr + Off;                                                    \
+    }                                                                        \
+    return skipClass(Ptr, End, Class);                                       \
+  }
+
+DRAGON_SSE2_SKIP(skipSpacesSSE2, isSpace128, CharScanner::SPACE)
+DRAGON_SSE2_SKIP(skipWordSSE2, isWord128, CharScanner::WORD)
+DRAGON_SSE2_SKIP(skipDigitsSSE2, isDigit128, CharScanner::DIGIT)
+
+#undef DRAGON_SSE2_SKIP
+
+const char *findSSE2(const char *Ptr, const char *End, char Char) {
+  auto Needle = _mm_set1_epi8(Char);
+  for (; End - Ptr >= 16; Ptr += 16) {
+    auto X = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+    if (unsigned Bits = _mm_movemask_epi8(_mm_cmpeq_epi8(X, Needle)))
+      return Ptr + __builtin_ctz(Bits);
+  }
+  return findChar(Ptr, End, Char);
+}
+
+/* AVX2 kernels, same as above on 32 bytes */
+
+#define DRAGON_AVX2 __attribute__((target("avx2")))
+
+DRAGON_AVX2 inline __m256i inRange256(__m256i X, char Lo, char Hi) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(X, _mm256_set1_epi8(Lo - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(Hi + 1), X));
+}
+
+DRAGON_AVX2 inline __m256i isSpace256(__m256i X) {
+  return _mm256_or_si256(_mm256_cmpeq_epi8(X, _mm256_set1_epi8(' ')),
+                         inRange256(X, '\t', '\r'));
+}
+
+DRAGON_AVX2 inline __m256i isDigit256(__m256i X) {
+  return inRange256(X, '0', '9');
+}
+
+DRAGON_AVX2 inline __m256i isWord256(__m256i X) {
+  auto Lower = _mm256_or_si256(X, _mm256_set1_epi8(0x20));
+  return _mm256_or_si256(
+      _mm256_or_si256(isDigit256(X), inRange256(Lower, 'a', 'z')),
+      _mm256_cmpeq_epi8(X, _mm256_set1_epi8('_')));
+}
+
+DRAGON_AVX2 inline unsigned firstMiss256(__m256i Mask) {
+  unsigned Bits = ~static_cast<unsigned>(_mm256_movemask_epi8(Mask));
+  return Bits ? __builtin_ctz(Bits) : 32;
+}
+
+// Tails shorter than a vector go through the SSE2 kernels, lines are often
+// shorter than 32 bytes.
+#define DRAGON_AVX2_SKIP(Name, Classify, Tail, Class)                        \
+  DRAGON_AVX2 const char *Name(const char *Ptr, const char *End) {           \
+    if (Ptr == End || !(Classes[static_cast<unsigned char>(*Ptr)] & Class))  \
+      return Ptr;                                                            \
+    for (; End - Ptr >= 32; Ptr += 32) {                                     \
+      auto X = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Ptr));   \
+      if (auto Off = firstMiss256(Classify(X)); Off != 32)                   \
+        return Ptr + Off;                                                    \
+    }                                                                        \
+    return Tail(Ptr, End);                                                   \
+  }
+
+DRAGON_AVX2_SKIP(skipSpacesAVX2, isSpace256, skipSpacesSSE2,
+                 CharScanner::SPACE)
+DRAGON_AVX2_SKIP(skipWordAVX2, isWord256, skipWordSSE2, CharScanner::WORD)
+DRAGON_AVX2_SKIP(skipDigitsAVX2, isDigit256, skipDigitsSSE2,
+                 CharScanner::DIGIT)
+
+#undef DRAGON_AVX2_SKIP
+
+DRAGON_AVX2 const char *findAVX2(const char *Ptr, const char *End, char Char) {
+  auto Needle = _mm256_set1_epi8(Char);
+  for (; End - Ptr >= 32; Ptr += 32) {
+    auto X = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Ptr));
+    if (unsigned Bits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(X, Needle)))
+      return Ptr + __builtin_ctz(Bits);
+  }
+  return findSSE2(Ptr, End, Char);
+}
+
+#undef DRAGON_AVX2
+
+#endif
+
+} // namespace
+
+const std::array<std::uint8_t, 256> CharScanner::mClasses = Classes;
+
+CharScanner::CharScanner(ScanLevel Level) : mLevel(Level) {
+  assert(isSupported(Level) && "Scan level is not supported by the CPU!");
+  switch (Level) {
+  case ScanLevel::SCALAR:
+    mSkipSpaces = skipSpacesScalar;
+    mSkipWord = skipWordScalar;
+    mSkipDigits = skipDigitsScalar;
+    mFind = findScalar;
+    break;
+#ifdef DRAGON_SCAN_X86
+  case ScanLevel::SSE2:
+    mSkipSpaces = skipSpacesSSE2;
+    mSkipWord = skipWordSSE2;
+    mSkipDigits = skipDigitsSSE2;
+    mFind = findSSE2;
+    break;
+  case ScanLevel::AVX2:
+    mSkipSpaces = skipSpacesAVX2;
+    mSkipWord = skipWordAVX2;
+    mSkipDigits = skipDigitsAVX2;
+    mFind = findAVX2;
+    break;
+#else
+  default:
+    mLevel = ScanLevel::SCALAR;
+    mSkipSpaces = skipSpacesScalar;
+    mSkipWord = skipWordScalar;
+    mSkipDigits = skipDigitsScalar;
+    mFind = findScalar;
+    break;
+#endif
+  }
+}
+
+bool CharScanner::isSupported(ScanLevel Level) {
+  switch (Level) {
+  case ScanLevel::SCALAR:
+    return true;
+#ifdef DRAGON_SCAN_X86
+  case ScanLevel::SSE2:
+    return __builtin_cpu_supports("sse2");
+  case ScanLevel::AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+// Runs in scripts are short, so the AVX2 kernels rarely get a full vector
+// and measure no faster than the SSE2 ones (see dragon-lexbench). They are
+// only used when asked for explicitly.
+ScanLevel CharScanner::getBestLevel() {
+  static const ScanLevel Best = isSupported(ScanLevel::SSE2) ?
+      ScanLevel::SSE2 : ScanLevel::SCALAR;
+  return Best;
+}
+
+const char *CharScanner::levelToString(ScanLevel Level) {
+  switch (Level) {
+  case ScanLevel::SCALAR: return "scalar";
+  case ScanLevel::SSE2: return "sse2";
+  case ScanLevel::AVX2: return "avx2";
+  }
+  return "<unknown level>";
+}
\ No newline at end of file
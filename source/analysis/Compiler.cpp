@@ -0,0 +1,485 @@
+#include "dragon/analysis/Compiler.h"
+#include "dragon/analysis/Builtins.h"
+#include "dragon/analysis/Optimizer.h"
+#include <deque>
+#include <functional>
+#include <optional>
+#include <set>
+
+typedef Keyword::Kind Kind;
+
+namespace {
+struct Node {
+  enum NodeKind {
+    CONST,
+    VAR,
+    CALL,
+    BUILTIN,
+    UNARY,
+    BINARY,
+    ASSIGN,
+    INDEX,
+    SLICE,
+    ARRAY,
+    GLOBAL,
+    RETURN,
+    JUMP,
+    COND_JUMP,
+    FOR,
+    FOR_STEP,
+    DELETE
+  };
+  NodeKind NK;
+  const Token *Tok;
+  std::vector<Node *> Ops;
+  std::size_t Target = 0;
+};
+
+std::optional<Opcode> getUnaryOpcode(Kind K) {
+  switch (K) {
+  case Kind::UNARY_PLUS: return Opcode::POS;
+  case Kind::UNARY_MINUS: return Opcode::NEG;
+  case Kind::LOGICAL_NOT: return Opcode::NOT;
+  case Kind::LEN: return Opcode::LEN;
+  case Kind::PRINT: return Opcode::PRINT;
+  case Kind::PRINTLN: return Opcode::PRINTLN;
+  default: return std::nullopt;
+  }
+}
+
+std::optional<Opcode> getBinaryOpcode(Kind K) {
+  switch (K) {
+  case Kind::PLUS: return Opcode::ADD;
+  case Kind::MINUS: return Opcode::SUB;
+  case Kind::MULTIPLY: return Opcode::MUL;
+  case Kind::DIVIDE: return Opcode::DIV;
+  case Kind::MODULE: return Opcode::MOD;
+  case Kind::SHL: return Opcode::SHL;
+  case Kind::SHR: return Opcode::SHR;
+  case Kind::BITWISE_AND: return Opcode::BIT_AND;
+  case Kind::BITWISE_OR: return Opcode::BIT_OR;
+  case Kind::BITWISE_XOR: return Opcode::BIT_XOR;
+  case Kind::LOGICAL_AND: return Opcode::AND;
+  case Kind::LOGICAL_OR: return Opcode::OR;
+  case Kind::EQUAL: return Opcode::EQ;
+  case Kind::NOT_EQUAL: return Opcode::NE;
+  case Kind::LESS: return Opcode::LT;
+  case Kind::LEQ: return Opcode::LE;
+  case Kind::GREATER: return Opcode::GT;
+  case Kind::GEQ: return Opcode::GE;
+  case Kind::IN: return Opcode::IN;
+  default: return std::nullopt;
+  }
+}
+} // namespace
+
+std::uint32_t Compiler::getGlobalSlot(std::string_view Name) {
+  auto Itr = mGlobalSlots.find(Name);
+  if (Itr != mGlobalSlots.end())
+    return Itr->second;
+  auto Slot = mGlobalFunc->addLocal(Name);
+  mGlobalSlots.emplace(Name, Slot);
+  return Slot;
+}
+
+void Compiler::compileFunction(const Function &F, CompiledFunction &CF) {
+  bool IsGlobalFunc = &CF == mGlobalFunc;
+  std::map<std::string, std::uint32_t, std::less<>> Slots;
+  for (auto Param : F.getParamList()) {
+    Slots.insert_or_assign(std::string(Param->getName()), CF.getParamCount());
+    CF.addParam(Param->getName());
+  }
+  auto &PL = F.getPostfixList();
+  // Names declared with `global` anywhere in a function refer to the global
+  // slot for the whole function body.
+  std::set<std::string, std::less<>> GlobalNames;
+  for (auto &Line : PL) {
+    for (std::size_t I = 1; I < Line.size(); ++I) {
+      auto Pref = dyn_cast<PrefixOperator>(Line[I]);
+      auto Id = dyn_cast<Identifier>(Line[I - 1]);
+      if (Pref && Id && Pref->getKind() == Kind::GLOBAL)
+        GlobalNames.emplace(Id->getName());
+    }
+  }
+  // Emits a load or a store of the variable named by the node token.
+  auto emitVar = [&](const Node *N, bool Store) {
+    auto &PI = N->Tok->getPosInfo();
+    auto Name = static_cast<const Identifier *>(N->Tok)->getName();
+    if (IsGlobalFunc) {
+      CF.emit(Store ? Opcode::STORE : Opcode::LOAD, PI, getGlobalSlot(Name));
+    } else if (GlobalNames.find(Name) != GlobalNames.end()) {
+      CF.emit(Store ? Opcode::STORE_GLOBAL : Opcode::LOAD_GLOBAL, PI,
+              getGlobalSlot(Name));
+    } else {
+      auto Itr = Slots.find(Name);
+      if (Itr == Slots.end())
+        Itr = Slots.emplace(Name, CF.addLocal(Name)).first;
+      CF.emit(Store ? Opcode::STORE : Opcode::LOAD, PI, Itr->second);
+    }
+  };
+  // Code offset of the first instruction of every postfix line.
+  std::vector<std::size_t> LineStart;
+  // Jumps to be patched once all lines are emitted: (instruction, line).
+  std::vector<std::pair<std::size_t, std::size_t>> Fixups;
+  // Slot of the iterable of every `for` loop by the line of its step.
+  std::map<std::size_t, std::uint32_t> LoopSlots;
+  std::deque<Node> Nodes;
+
+  std::function<void(const Node *)> emitExpr = [&](const Node *N) {
+    auto &PI = N->Tok->getPosInfo();
+    switch (N->NK) {
+    case Node::CONST:
+      CF.emit(Opcode::PUSH_CONST, PI, CF.addConstant(
+          static_cast<const Constant *>(N->Tok)));
+      break;
+    case Node::VAR:
+      emitVar(N, false);
+      break;
+    case Node::CALL:
+      for (auto Arg : N->Ops)
+        emitExpr(Arg);
+      CF.emit(Opcode::CALL, PI,
+              static_cast<const FunctionCall *>(N->Tok)->getIndex(), 1);
+      break;
+    case Node::BUILTIN:
+      for (auto Arg : N->Ops)
+        emitExpr(Arg);
+      CF.emit(Opcode::CALL_NATIVE, PI,
+              static_cast<const BuiltinCall *>(N->Tok)->getIndex());
+      break;
+    case Node::UNARY: {
+      emitExpr(N->Ops[0]);
+      auto Kw = static_cast<const Keyword *>(N->Tok);
+      if (auto Op = getUnaryOpcode(Kw->getKind()))
+        CF.emit(*Op, PI);
+      break;
+    }
+    case Node::BINARY:
+      emitExpr(N->Ops[0]);
+      emitExpr(N->Ops[1]);
+      CF.emit(*getBinaryOpcode(static_cast<const Keyword *>(
+          N->Tok)->getKind()), PI);
+      break;
+    case Node::ASSIGN: {
+      auto Target = N->Ops[0];
+      emitExpr(N->Ops[1]);
+      if (Target->NK == Node::VAR) {
+        emitVar(Target, true);
+        break;
+      }
+      // The value is evaluated before the array and the index.
+      emitExpr(Target->Ops[0]);
+      emitExpr(Target->Ops[1]);
+      CF.emit(Opcode::STORE_INDEX, Target->Tok->getPosInfo());
+      break;
+    }
+    case Node::INDEX:
+    case Node::SLICE:
+      for (auto Op : N->Ops)
+        emitExpr(Op);
+      CF.emit(N->NK == Node::INDEX ? Opcode::LOAD_INDEX : Opcode::SLICE, PI);
+      break;
+    case Node::ARRAY:
+      for (auto Elem : N->Ops)
+        emitExpr(Elem);
+      CF.emit(Opcode::MAKE_ARRAY, PI, N->Ops.size());
+      break;
+    default:
+      throw SyntaxException("Unexpected statement inside expression at " +
+                            N->Tok->getPos());
+    }
+  };
+
+  auto emitStatement = [&](const Node *N) {
+    auto &PI = N->Tok->getPosInfo();
+    switch (N->NK) {
+    case Node::GLOBAL:
+      CF.emit(Opcode::GLOBAL, PI, getGlobalSlot(
+          static_cast<const Identifier *>(N->Ops[0]->Tok)->getName()));
+      break;
+    case Node::RETURN: {
+      if (N->Ops.empty()) {
+        CF.emit(Opcode::RET_VOID, PI);
+        break;
+      }
+      auto Val = N->Ops[0];
+      // A call in tail position reuses the frame, unless the callee returns
+      // nothing and the call has to fail where it is written.
+      if (Val->NK == Node::CALL) {
+        auto Callee = static_cast<const FunctionCall *>(Val->Tok)->getIndex();
+        if (mSA.getFuncList()[Callee].returnsValue() ||
+            &mFuncs[Callee] == &CF) {
+          for (auto Arg : Val->Ops)
+            emitExpr(Arg);
+          CF.emit(Opcode::TAIL_CALL, Val->Tok->getPosInfo(), Callee);
+          break;
+        }
+      }
+      emitExpr(Val);
+      CF.emit(Opcode::RET, PI);
+      break;
+    }
+    case Node::JUMP:
+      Fixups.emplace_back(CF.emit(Opcode::JMP, PI), N->Target);
+      break;
+    case Node::COND_JUMP:
+      emitExpr(N->Ops[0]);
+      Fixups.emplace_back(CF.emit(Opcode::JMP_IF,
+          N->Ops[0]->Tok->getPosInfo()), N->Target);
+      break;
+    case Node::CALL:
+      for (auto Arg : N->Ops)
+        emitExpr(Arg);
+      CF.emit(Opcode::CALL, PI,
+              static_cast<const FunctionCall *>(N->Tok)->getIndex(), 0);
+      break;
+    case Node::FOR: {
+      // The iterable and the position in it take two hidden slots, under
+      // names no variable can have. The step is on the next line.
+      auto Slot = CF.addLocal("$for");
+      CF.addLocal("$for.pos");
+      LoopSlots.emplace(LineStart.size(), Slot);
+      emitExpr(N->Ops[0]);
+      CF.emit(Opcode::FOR_PREP, PI, Slot);
+      break;
+    }
+    case Node::FOR_STEP: {
+      auto Loop = LoopSlots.find(LineStart.size() - 1);
+      if (Loop == LoopSlots.end())
+        throw SyntaxException("No `for` for the loop step at " +
+                              N->Tok->getPos());
+      Fixups.emplace_back(CF.emit(Opcode::FOR_NEXT, PI, 0, Loop->second),
+                          N->Target);
+      emitVar(N->Ops[0], true);
+      CF.emit(Opcode::POP, PI);
+      break;
+    }
+    case Node::DELETE: {
+      auto Elem = N->Ops[0];
+      emitExpr(Elem->Ops[0]);
+      emitExpr(Elem->Ops[1]);
+      CF.emit(Opcode::DELETE_INDEX, Elem->Tok->getPosInfo());
+      break;
+    }
+    default:
+      emitExpr(N);
+      CF.emit(Opcode::POP, PI);
+    }
+  };
+
+  auto getTarget = [](const Node *N, const Token *Op) -> std::size_t {
+    auto Int = dyn_cast<Integer>(N->Tok);
+    if (N->NK != Node::CONST || !Int)
+      throw SyntaxException("Integer position expected for goto at " +
+                            Op->getPos());
+    return Int->getValue();
+  };
+
+  for (auto &Line : PL) {
+    LineStart.push_back(CF.getCode().size());
+    std::vector<Node *> Stack;
+    auto pop = [&Stack](const Token *Op) {
+      if (Stack.empty())
+        throw SyntaxException("Not enough operands at " + Op->getPos());
+      auto Top = Stack.back();
+      Stack.pop_back();
+      return Top;
+    };
+    for (auto Tok : Line) {
+      switch (Tok->getTokenKind()) {
+      case TokenKind::STRING:
+      case TokenKind::FLOAT:
+      case TokenKind::INTEGER:
+      case TokenKind::BOOLEAN:
+        Stack.push_back(&Nodes.emplace_back(Node{ Node::CONST, Tok }));
+        break;
+      case TokenKind::FUNCTION_CALL: {
+        auto Call = cast<FunctionCall>(Tok);
+        auto ParamCount = mSA.getFuncList()[Call->getIndex()].
+            getParamList().size();
+        if (Stack.size() < ParamCount)
+          throw SyntaxException("Not enough arguments for function at " +
+                                Call->getPos());
+        auto &CallNode = Nodes.emplace_back(Node{ Node::CALL, Tok });
+        CallNode.Ops.assign(Stack.end() - ParamCount, Stack.end());
+        Stack.resize(Stack.size() - ParamCount);
+        Stack.push_back(&CallNode);
+        break;
+      }
+      case TokenKind::BUILTIN_CALL: {
+        auto Call = cast<BuiltinCall>(Tok);
+        auto ParamCount = getBuiltin(Call->getIndex()).ParamCount;
+        if (Stack.size() < ParamCount)
+          throw SyntaxException("Not enough arguments for function at " +
+                                Call->getPos());
+        auto &CallNode = Nodes.emplace_back(Node{ Node::BUILTIN, Tok });
+        CallNode.Ops.assign(Stack.end() - ParamCount, Stack.end());
+        Stack.resize(Stack.size() - ParamCount);
+        Stack.push_back(&CallNode);
+        break;
+      }
+      case TokenKind::IDENTIFIER:
+        Stack.push_back(&Nodes.emplace_back(Node{ Node::VAR, Tok }));
+        break;
+      case TokenKind::PREFIX_OPERATOR: {
+        auto Pref = cast<PrefixOperator>(Tok);
+        switch (Pref->getKind()) {
+        case Kind::RETURN: {
+          auto &Ret = Nodes.emplace_back(Node{ Node::RETURN, Tok });
+          if (!Stack.empty())
+            Ret.Ops.push_back(pop(Tok));
+          Stack.push_back(&Ret);
+          break;
+        }
+        case Kind::GLOBAL: {
+          auto &Glob = Nodes.emplace_back(Node{ Node::GLOBAL, Tok });
+          Glob.Ops.push_back(pop(Tok));
+          if (Glob.Ops[0]->NK != Node::VAR)
+            throw SyntaxException("Not an identifier after `global` at " +
+                                  Tok->getPos());
+          Stack.push_back(&Glob);
+          break;
+        }
+        case Kind::GOTO_UN: {
+          auto &Jump = Nodes.emplace_back(Node{ Node::JUMP, Tok });
+          Jump.Target = getTarget(pop(Tok), Tok);
+          Stack.push_back(&Jump);
+          break;
+        }
+        case Kind::FOR: {
+          auto &For = Nodes.emplace_back(Node{ Node::FOR, Tok });
+          For.Ops.push_back(pop(Tok));
+          Stack.push_back(&For);
+          break;
+        }
+        case Kind::DELETE: {
+          auto &Delete = Nodes.emplace_back(Node{ Node::DELETE, Tok });
+          Delete.Ops.push_back(pop(Tok));
+          if (Delete.Ops[0]->NK != Node::INDEX)
+            throw SyntaxException("Dict element expected after `delete` at " +
+                                  Tok->getPos());
+          Stack.push_back(&Delete);
+          break;
+        }
+        case Kind::SLICE: {
+          auto &Slice = Nodes.emplace_back(Node{ Node::SLICE, Tok });
+          auto High = pop(Tok);
+          auto Low = pop(Tok);
+          Slice.Ops = { pop(Tok), Low, High };
+          Stack.push_back(&Slice);
+          break;
+        }
+        case Kind::MAKE_ARRAY: {
+          auto Count = cast<Integer>(pop(Tok)->Tok)->getValue();
+          if (Stack.size() < static_cast<std::size_t>(Count))
+            throw SyntaxException("Not enough elements for array at " +
+                                  Tok->getPos());
+          auto &Array = Nodes.emplace_back(Node{ Node::ARRAY, Tok });
+          Array.Ops.assign(Stack.end() - Count, Stack.end());
+          Stack.resize(Stack.size() - Count);
+          Stack.push_back(&Array);
+          break;
+        }
+        case Kind::UNARY_PLUS:
+        case Kind::UNARY_MINUS:
+        case Kind::LOGICAL_NOT:
+        case Kind::LEN:
+        case Kind::PRINT:
+        case Kind::PRINTLN: {
+          if (Stack.empty())
+            throw SyntaxException("Unexpected unary operator at " +
+                                  Tok->getPos());
+          auto &Un = Nodes.emplace_back(Node{ Node::UNARY, Tok });
+          Un.Ops.push_back(pop(Tok));
+          Stack.push_back(&Un);
+          break;
+        }
+        default:
+          throw SyntaxException("Unexpected keyword `" + Pref->kindToString() +
+                                "` at " + Tok->getPos());
+        }
+        break;
+      }
+      case TokenKind::BINARY_OPERATOR: {
+        auto Bin = cast<BinaryOperator>(Tok);
+        auto Right = pop(Tok);
+        auto Left = pop(Tok);
+        if (Bin->getKind() == Kind::GOTO_BIN) {
+          auto &Jump = Nodes.emplace_back(Node{ Node::COND_JUMP, Tok });
+          Jump.Ops.push_back(Left);
+          Jump.Target = getTarget(Right, Tok);
+          Stack.push_back(&Jump);
+        } else if (Bin->getKind() == Kind::FOR_NEXT) {
+          if (Left->NK != Node::VAR)
+            throw SyntaxException("Variable expected for the loop step at " +
+                                  Tok->getPos());
+          auto &Step = Nodes.emplace_back(Node{ Node::FOR_STEP, Tok });
+          Step.Ops.push_back(Left);
+          Step.Target = getTarget(Right, Tok);
+          Stack.push_back(&Step);
+        } else if (Bin->getKind() == Kind::ASSIGN) {
+          if (Left->NK != Node::VAR && Left->NK != Node::INDEX)
+            throw SyntaxException("R-value error at " + Tok->getPos());
+          auto &Assign = Nodes.emplace_back(Node{ Node::ASSIGN, Tok });
+          Assign.Ops = { Left, Right };
+          Stack.push_back(&Assign);
+        } else if (Bin->getKind() == Kind::INDEX) {
+          auto &Index = Nodes.emplace_back(Node{ Node::INDEX, Tok });
+          Index.Ops = { Left, Right };
+          Stack.push_back(&Index);
+        } else if (getBinaryOpcode(Bin->getKind())) {
+          auto &BinNode = Nodes.emplace_back(Node{ Node::BINARY, Tok });
+          BinNode.Ops = { Left, Right };
+          Stack.push_back(&BinNode);
+        } else {
+          throw SyntaxException("Unexpected keyword `" + Bin->kindToString() +
+                                "` at " + Tok->getPos());
+        }
+        break;
+      }
+      default:
+        throw SyntaxException("Unexpected token at " + Tok->getPos());
+      }
+    }
+    for (auto Stmt : Stack)
+      emitStatement(Stmt);
+  }
+  LineStart.push_back(CF.getCode().size());
+  CF.emit(Opcode::RET_VOID, PosInfo());
+  for (auto &Fixup : Fixups) {
+    if (Fixup.second >= LineStart.size())
+      throw SyntaxException("Jump out of function `" + CF.getName() + "`");
+    CF.getCode()[Fixup.first].A = LineStart[Fixup.second];
+  }
+}
+
+Compiler::Compiler(SyntaxAnalyzer &SA, unsigned OptLevel)
+    : mSA(SA), mOptLevel(OptLevel) {
+  auto &Funcs = SA.getFuncList();
+  mFuncs.reserve(Funcs.size());
+  for (auto &Func : Funcs)
+    mFuncs.emplace_back(Func.getName());
+  mGlobalFunc = &mFuncs[*SA.findFunction(GLOBAL_FUNC)];
+  for (std::size_t I = 0; I < Funcs.size(); ++I)
+    if (Funcs[I].hasPostfix())
+      compile(I);
+  DRAGON_DEBUG(dump());
+}
+
+void Compiler::compile(std::size_t Idx) {
+  if (isCompiled(Idx))
+    return;
+  mSA.generateFunction(Idx);
+  compileFunction(mSA.getFuncList()[Idx], mFuncs[Idx]);
+  if (mOptLevel > 0)
+    Optimizer Opt(mFuncs[Idx]);
+  DRAGON_DEBUG(dbgs() << "[COMPILER] Compiled function `" <<
+               mFuncs[Idx].getName() << "`.\n");
+}
+
+void Compiler::dump() const {
+  dbgs() << "[COMPILER] Bytecode for functions:\n";
+  for (auto &Func : mFuncs)
+    Func.dump();
+  dbgs() << "[COMPILER] End printing bytecode.\n";
+}
\ No newline at end of file
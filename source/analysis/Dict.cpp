@@ -0,0 +1,134 @@
+#include "dragon/analysis/Dict.h"
+#include <algorithm>
+#include <functional>
+#include <new>
+
+namespace {
+// Final mix of splitmix64, it spreads sequential ints over the whole index.
+std::uint64_t mix(std::uint64_t X) {
+  X ^= X >> 30;
+  X *= 0xbf58476d1ce4e5b9;
+  X ^= X >> 27;
+  X *= 0x94d049bb133111eb;
+  return X ^ (X >> 31);
+}
+
+bool isSameKey(const Value &Left, const Value &Right) {
+  if (Left.isInt())
+    return Right.isInt() && Left.getInt() == Right.getInt();
+  return Right.isString() && Left.getString() == Right.getString();
+}
+
+void releaseRef(const Value &Val) {
+  if (!Val.hasObject())
+    return;
+  auto Obj = Val.getObject();
+  if (Obj->isCounted() && Obj->release())
+    StringObject::destroy(Obj);
+}
+} // namespace
+
+Dict::~Dict() {
+  for (auto &E : mEntries) {
+    releaseRef(E.Key);
+    releaseRef(E.Val);
+  }
+}
+
+std::uint64_t Dict::hash(const Value &Key) {
+  assert(isKey(Key) && "Dict keys are ints or strings!");
+  if (Key.isInt())
+    return mix(Key.getInt());
+  // Never equal to the hash of the int with the same bits.
+  return mix(std::hash<std::string_view>()(Key.getString()) + 1) ^ 1;
+}
+
+std::size_t Dict::findSlot(const Value &Key, std::uint64_t Hash) const {
+  if (mIndex.empty())
+    return mIndex.size();
+  auto Short = static_cast<std::uint32_t>(Hash);
+  auto Mask = getMask();
+  for (auto Idx = Short & Mask; mIndex[Idx].Entry; Idx = (Idx + 1) & Mask) {
+    if (mIndex[Idx].Hash != Short)
+      continue;
+    auto &E = mEntries[mIndex[Idx].Entry - 1];
+    if (E.Hash == Hash && isSameKey(E.Key, Key))
+      return Idx;
+  }
+  return mIndex.size();
+}
+
+Value *Dict::find(const Value &Key, std::uint64_t Hash) {
+  auto Idx = findSlot(Key, Hash);
+  if (Idx == mIndex.size())
+    return nullptr;
+  return &mEntries[mIndex[Idx].Entry - 1].Val;
+}
+
+void Dict::place(std::uint64_t Hash, std::size_t Pos) {
+  auto Short = static_cast<std::uint32_t>(Hash);
+  auto Mask = getMask();
+  auto Idx = Short & Mask;
+  while (mIndex[Idx].Entry)
+    Idx = (Idx + 1) & Mask;
+  mIndex[Idx] = { Short, static_cast<std::uint32_t>(Pos + 1) };
+}
+
+// The index stays at most half full right after a rebuild. The entries,
+// erased ones included, may fill it up to three quarters until the next one,
+// so a dict that keeps erasing and inserting compacts its entries at
+// amortized constant cost.
+void Dict::rebuild() {
+  mEntries.erase(std::remove_if(mEntries.begin(), mEntries.end(),
+                                [](const Entry &E) { return E.Key.isNil(); }),
+                 mEntries.end());
+  std::size_t Size = 8;
+  while (Size < (mSize + 1) * 2)
+    Size *= 2;
+  mIndex.assign(Size, Slot{ 0, 0 });
+  for (std::size_t Pos = 0; Pos < mEntries.size(); ++Pos)
+    place(mEntries[Pos].Hash, Pos);
+}
+
+void Dict::insert(const Value &Key, const Value &Val, std::uint64_t Hash) {
+  assert(findSlot(Key, Hash) == mIndex.size() && "Key is already present!");
+  if (mEntries.size() >= mIndex.size() / 4 * 3)
+    rebuild();
+  assert(mEntries.size() < UINT32_MAX && "Too many entries!");
+  mEntries.push_back({ Hash, Key, Val });
+  place(Hash, mEntries.size() - 1);
+  ++mSize;
+}
+
+bool Dict::erase(const Value &Key, std::uint64_t Hash) {
+  auto Hole = findSlot(Key, Hash);
+  if (Hole == mIndex.size())
+    return false;
+  auto &E = mEntries[mIndex[Hole].Entry - 1];
+  releaseRef(E.Key);
+  releaseRef(E.Val);
+  E.Key = Value();
+  E.Val = Value();
+  --mSize;
+  // A following slot moves into the hole unless its home lies after the
+  // hole, where a lookup starting at the home would no longer pass it.
+  auto Mask = getMask();
+  for (auto Idx = (Hole + 1) & Mask; mIndex[Idx].Entry;
+       Idx = (Idx + 1) & Mask) {
+    auto Home = mIndex[Idx].Hash & Mask;
+    if (((Idx - Home) & Mask) >= ((Idx - Hole) & Mask)) {
+      mIndex[Hole] = mIndex[Idx];
+      Hole = Idx;
+    }
+  }
+  mIndex[Hole] = Slot{ 0, 0 };
+  return true;
+}
+
+const StringObject *Dict::create() {
+  auto Obj = StringObject::create(
+      new char[StringObject::getAllocSize(sizeof(Dict))], sizeof(Dict), 1);
+  Obj->mHoldsDict = true;
+  new (Obj->getData()) Dict();
+  return Obj;
+}
\ No newline at end of file
@@ -1,533 +1,852 @@
 #include "dragon/analysis/Interpreter.h"
-#include <optional>
-
-typedef Keyword::Kind Kind;
-
-const double EPS = std::numeric_limits<double>::epsilon();
-
-Interpreter::VarTableItrPair Interpreter::getVarItr(
-      const Identifier *Id, bool Exception) {
-  auto &GlobVars = mGlobVarSetStack.front();
-  if (GlobVars.find(Id->getName()) != GlobVars.end() &&
-      mFuncStack.top()->getName() != GLOBAL_FUNC) {
-    auto &GlobVT = mVarTableStack.back();
-    auto GlobItr = GlobVT.find(Id->getName());
-    assert(GlobItr != GlobVT.end() &&
-        "Global variable must have an entry in a global table!");
-    return std::make_pair(GlobItr, &GlobVT);
-  }
-  auto &VT = mVarTableStack.front();
-  auto VarItr = VT.find(Id->getName());
-  if (VarItr == VT.end() && Exception)
-    throw InterpreterException("Variable with name `" +
-        Id->getName() + "` used at " + Id->getPos() +
-        " does not exist in this scope");
-  return std::make_pair(VarItr, &VT);
-}
+#include "dragon/analysis/Builtins.h"
+#include "dragon/analysis/Dict.h"
+#include <algorithm>
+#include <limits>
 
-void Interpreter::processUnary(const PrefixOperator *Op, Token *Top) {
-  DRAGON_DEBUG(dbgs() << "[RUNTIME] Processing unary operator `" <<
-               Op->kindToString() << "` for token " << Top->toString() << ".\n");
-  if (auto Id = dynamic_cast<Identifier *>(Top)) {
-    auto ConstItrPair = getVarItr(Id);
-    if (ConstItrPair.first != ConstItrPair.second->end()) {
-      Top = ConstItrPair.first->second;
+void Interpreter::processPrint(const Value &Top, bool NewLine,
+                               const PosInfo &PI) {
+  // Strings inside a dict are quoted, so that keys 1 and "1" differ.
+  auto printElement = [this, &PI](const Value &Elem) {
+    if (Elem.isString()) {
+      mOut.write("\"");
+      mOut.write(Elem.getString());
+      mOut.write("\"");
     } else {
-      throw InterpreterException("Variable with name `" + Id->getName() +
-          "` does not exist in this scope at " + Op->getPos());
+      processPrint(Elem, false, PI);
+    }
+  };
+  switch (Top.getType()) {
+  case Value::INTEGER:
+    mOut.write(static_cast<long long>(Top.getInt()));
+    break;
+  case Value::FLOAT:
+    mOut.write(Top.getFloat());
+    break;
+  case Value::STRING:
+    mOut.write(Top.getString());
+    break;
+  case Value::BOOLEAN:
+    mOut.write(Top.getBool() ? "true" : "false");
+    break;
+  case Value::BIGINT:
+    mOut.write(Top.getBigInt().toString());
+    break;
+  case Value::ARRAY:
+    mOut.write("[");
+    for (std::size_t Idx = 0; Idx < Top.getArrayLength(); ++Idx) {
+      if (Idx)
+        mOut.write(", ");
+      if (Top.getElementType() == Value::FLOAT)
+        mOut.write(Top.getFloats()[Idx]);
+      else
+        mOut.write(static_cast<long long>(Top.getInts()[Idx]));
     }
+    mOut.write("]");
+    break;
+  case Value::DICT: {
+    auto &D = Top.getDict();
+    mOut.write("{");
+    bool First = true;
+    for (std::size_t Idx = 0; Idx < D.getEntryCount(); ++Idx) {
+      auto &E = D.getEntry(Idx);
+      if (E.Key.isNil())
+        continue;
+      if (!First)
+        mOut.write(", ");
+      First = false;
+      printElement(E.Key);
+      mOut.write(": ");
+      printElement(E.Val);
+    }
+    mOut.write("}");
+    break;
+  }
+  default:
+    throw InterpreterException("Unexpected operand type for print at " +
+                               Token::posToString(PI));
+  }
+  if (NewLine)
+    mOut.writeNewLine();
+}
+
+// Variables share strings: only a temporary from the arena is copied, into a
+// counted heap object.
+Value Interpreter::makeOwned(const Value &Val) {
+  if (!Val.hasObject())
+    return Val;
+  auto Obj = Val.getObject();
+  if (Obj->isCounted()) {
+    Obj->retain();
+    return Val;
+  }
+  if (!Obj->isTemporary())
+    return Val;
+  // Temporaries are never appended to, the value covers the whole object.
+  auto Bytes = Obj->getView();
+  auto Copy = StringObject::create(
+      new char[StringObject::getAllocSize(Bytes.size())], Bytes, 1);
+  return Val.withObject(Copy);
+}
+
+void Interpreter::releaseOwned(Value &Val) {
+  if (Val.hasObject()) {
+    auto Obj = Val.getObject();
+    if (Obj->isCounted() && Obj->release())
+      StringObject::destroy(Obj);
+  }
+  Val = Value();
+}
+
+Value Interpreter::load(const Value &Var) {
+  if (Var.hasObject() && Var.getObject()->isCounted()) {
+    Var.getObject()->retain();
+    mTempRefs.push_back(Var.getObject());
+  }
+  return Var;
+}
+
+// Concatenation whose left operand is a variable's string. The result goes to
+// a heap buffer with spare capacity, so a string that is grown in a loop is
+// extended in place from then on.
+Value Interpreter::appendString(const Value &Left, std::string_view Right,
+                                const PosInfo &PI) {
+  auto Obj = Left.getStringObject();
+  auto Str = Left.getString();
+  auto Length = Str.size() + Right.size();
+  if (Length > std::numeric_limits<std::uint32_t>::max())
+    throw InterpreterException("String is too long at " +
+                               Token::posToString(PI));
+  if (Obj->canAppend(Str.size(), Right.size())) {
+    Obj->retain();
+  } else {
+    auto Capacity = std::min<std::size_t>(
+        Length * 2, std::numeric_limits<std::uint32_t>::max());
+    Obj = StringObject::create(new char[StringObject::getAllocSize(Capacity)],
+                               Str, 1, Capacity);
+  }
+  Obj->append(Right);
+  mTempRefs.push_back(Obj);
+  return Value(Obj, Length);
+}
+
+namespace {
+// The byte length of the elements must fit in a StringObject.
+constexpr std::size_t MaxArrayLength =
+    std::numeric_limits<std::uint32_t>::max() / sizeof(std::int64_t);
+
+std::size_t checkIndex(const Value &Array, const Value &Index,
+                       const PosInfo &PI) {
+  if (!Array.isArray())
+    throw InterpreterException("Indexed value is not an array at " +
+                               Token::posToString(PI));
+  if (!Index.isInt())
+    throw InterpreterException("Array index must be an int at " +
+                               Token::posToString(PI));
+  if (Index.getInt() < 0 ||
+      static_cast<std::uint64_t>(Index.getInt()) >= Array.getArrayLength())
+    throw InterpreterException("Array index " +
+        std::to_string(Index.getInt()) + " is out of range at " +
+        Token::posToString(PI));
+  return Index.getInt();
+}
+
+void storeElement(const Value &Array, std::size_t Idx, const Value &Elem,
+                  const PosInfo &PI) {
+  if (Array.setElement(Idx, Elem))
+    return;
+  if (Elem.isFloat())
+    throw InterpreterException("Float stored into an int array at " +
+                               Token::posToString(PI));
+  if (Elem.isBigInt())
+    throw InterpreterException("Integer is too large for an array at " +
+                               Token::posToString(PI));
+  throw InterpreterException("Array elements must be numbers at " +
+                             Token::posToString(PI));
+}
+
+// Hash of a dict key, which must be an int or a string.
+std::uint64_t hashKey(const Value &Key, const PosInfo &PI) {
+  if (!Dict::isKey(Key))
+    throw InterpreterException("Dict keys must be ints or strings at " +
+                               Token::posToString(PI));
+  return Dict::hash(Key);
+}
+
+[[noreturn]] void throwMissingKey(const Value &Key, const PosInfo &PI) {
+  throw InterpreterException("Key " + (Key.isInt() ?
+      std::to_string(Key.getInt()) :
+      "\"" + std::string(Key.getString()) + "\"") +
+      " is not in the dict at " + Token::posToString(PI));
+}
+
+Value &findKey(Dict &D, const Value &Key, const PosInfo &PI) {
+  if (auto Found = D.find(Key, hashKey(Key, PI)))
+    return *Found;
+  throwMissingKey(Key, PI);
+}
+
+// Copies Count elements of From starting at Begin to position At of To. Int
+// elements are converted if To holds floats.
+void copyElements(const Value &From, std::size_t Begin, std::size_t Count,
+                  const Value &To, std::size_t At) {
+  if (To.getElementType() == Value::INTEGER)
+    std::copy_n(From.getInts() + Begin, Count, To.getInts() + At);
+  else if (From.getElementType() == Value::FLOAT)
+    std::copy_n(From.getFloats() + Begin, Count, To.getFloats() + At);
+  else
+    std::copy_n(From.getInts() + Begin, Count, To.getFloats() + At);
+}
+} // namespace
+
+// Arrays are created right on the heap, they are often too large to be worth
+// a copy from the arena. Like the result of appendString(), a new array is
+// held by the statement until a variable takes it.
+Value Interpreter::createArray(Value::Type ElementType, std::size_t Length,
+                               const PosInfo &PI) {
+  if (Length > MaxArrayLength)
+    throw InterpreterException("Array is too long at " +
+                               Token::posToString(PI));
+  auto Size = Length * sizeof(std::int64_t);
+  auto Obj = StringObject::create(new char[StringObject::getAllocSize(Size)],
+                                  Size, 1);
+  // All bits zero is 0 and 0.0 alike.
+  std::fill_n(Obj->getData(), Size, 0);
+  mTempRefs.push_back(Obj);
+  return Value::makeArray(Obj, ElementType);
+}
+
+// Like arrays, dicts only live on the heap.
+Value Interpreter::createDict() {
+  auto Obj = Dict::create();
+  mTempRefs.push_back(Obj);
+  return Value::makeDict(Obj);
+}
+
+// The dict takes its own references to the key and the value.
+void Interpreter::storeKey(Dict &D, const Value &Key, const Value &Val,
+                           const PosInfo &PI) {
+  auto Hash = hashKey(Key, PI);
+  auto Stored = makeOwned(Val);
+  if (auto Found = D.find(Key, Hash)) {
+    releaseOwned(*Found);
+    *Found = Stored;
+  } else {
+    D.insert(makeOwned(Key), Stored, Hash);
+  }
+}
+
+// Replaces the top Count values of the operand stack with an array of them.
+// It holds floats if any of them is a float.
+void Interpreter::makeArray(std::size_t Count, const PosInfo &PI) {
+  auto Elems = mStack.end() - Count;
+  auto ElementType = Value::INTEGER;
+  for (auto Itr = Elems; Itr != mStack.end(); ++Itr)
+    if (Itr->isFloat())
+      ElementType = Value::FLOAT;
+  auto Array = createArray(ElementType, Count, PI);
+  for (std::size_t Idx = 0; Idx < Count; ++Idx)
+    storeElement(Array, Idx, Elems[Idx], PI);
+  mStack.resize(mStack.size() - Count);
+  mStack.push_back(Array);
+}
+
+// Bounds are clamped to the array, an empty range gives an empty array.
+Value Interpreter::sliceArray(const Value &Array, const Value &Low,
+                              const Value &High, const PosInfo &PI) {
+  if (!Array.isArray())
+    throw InterpreterException("Sliced value is not an array at " +
+                               Token::posToString(PI));
+  if (!Low.isInt() || !High.isInt())
+    throw InterpreterException("Slice bounds must be ints at " +
+                               Token::posToString(PI));
+  std::int64_t Length = Array.getArrayLength();
+  auto Begin = std::clamp<std::int64_t>(Low.getInt(), 0, Length);
+  auto End = std::clamp<std::int64_t>(High.getInt(), Begin, Length);
+  auto Res = createArray(Array.getElementType(), End - Begin, PI);
+  copyElements(Array, Begin, End - Begin, Res, 0);
+  return Res;
+}
+
+// `+` concatenates two arrays, `*` repeats an array a number of times. Other
+// operators fail as they do for any mismatched operands.
+Value Interpreter::processArray(Opcode Op, const Value &Left,
+                                const Value &Right, const PosInfo &PI) {
+  if (Op == Opcode::ADD && Left.isArray() && Right.isArray()) {
+    auto LeftLength = Left.getArrayLength();
+    auto ElementType = Left.getElementType() == Value::FLOAT ?
+                       Value::FLOAT : Right.getElementType();
+    auto Res = createArray(ElementType, LeftLength + Right.getArrayLength(),
+                           PI);
+    copyElements(Left, 0, LeftLength, Res, 0);
+    copyElements(Right, 0, Right.getArrayLength(), Res, LeftLength);
+    return Res;
+  }
+  if (Op == Opcode::MUL && (Left.isInt() || Right.isInt())) {
+    auto &Array = Left.isArray() ? Left : Right;
+    auto Times = std::max<std::int64_t>(
+        Left.isArray() ? Right.getInt() : Left.getInt(), 0);
+    auto Length = Array.getArrayLength();
+    if (Length && static_cast<std::uint64_t>(Times) > MaxArrayLength / Length)
+      throw InterpreterException("Array is too long at " +
+                                 Token::posToString(PI));
+    auto Res = createArray(Array.getElementType(), Length * Times, PI);
+    for (std::int64_t Idx = 0; Idx < Times; ++Idx)
+      copyElements(Array, 0, Length, Res, Idx * Length);
+    return Res;
+  }
+  return processBinary(Op, Left, Right, PI, mArena);
+}
+
+void Interpreter::releaseTempRefs(std::size_t Count) {
+  while (mTempRefs.size() > Count) {
+    auto Obj = mTempRefs.back();
+    if (Obj->release())
+      StringObject::destroy(Obj);
+    mTempRefs.pop_back();
+  }
+}
+
+namespace {
+// Instruction::B of a generic binary operator holds its type feedback: the
+// quickened opcode matching the last operands in the upper half and the
+// number of times in a row it was seen in the lower half.
+constexpr std::uint32_t QuickeningThreshold = 8;
+constexpr std::uint32_t FeedbackCountMask = 0xffff;
+constexpr std::uint32_t Megamorphic = ~0u;
+
+void recordFeedback(Instruction &I, const Value &Left, const Value &Right) {
+  if (I.B == Megamorphic)
+    return;
+  auto Quick = getQuickenedOpcode(I.Op, Left.getType(), Right.getType());
+  if (!Quick) {
+    I.B = Megamorphic;
+    return;
+  }
+  auto Seen = static_cast<std::uint32_t>(*Quick) << 16;
+  if ((I.B & ~FeedbackCountMask) != Seen)
+    I.B = Seen;
+  if ((++I.B & FeedbackCountMask) == QuickeningThreshold) {
+    I.Op = *Quick;
+    I.B = 0;
+  }
+}
+
+// Reverts a quickened site whose guard failed. The site stays generic from
+// now on, so a polymorphic site does not flip between the two forms.
+void deoptimize(Instruction &I) {
+  I.Op = getGenericOpcode(I.Op);
+  I.B = Megamorphic;
+}
+} // namespace
+
+void Interpreter::compileFunction(std::size_t FuncIdx) {
+  assert(mCompiler && "Only a compiler can provide missing functions!");
+  auto GlobalCount = mGlobalFunc.getFrameSize();
+  mCompiler->compile(FuncIdx);
+  mCode[FuncIdx] = mFuncs[FuncIdx].getCode();
+  // A `global` declaration in the new code may have added global slots, the
+  // frames above the globals move up to make room for them.
+  if (auto Added = mGlobalFunc.getFrameSize() - GlobalCount) {
+    mSlots.insert(mSlots.begin() + GlobalCount, Added, Value());
+    for (auto &Frame : mFrames)
+      if (Frame.Func != &mGlobalFunc)
+        Frame.Base += Added;
   }
-  if (auto Int = dynamic_cast<Integer *>(Top)) {
-    switch (Op->getKind()) {
-    case Kind::UNARY_MINUS:
-      Int->setValue(-Int->getValue());
+}
+
+void Interpreter::pushFrame(std::size_t FuncIdx, const PosInfo &PI) {
+  if (mCode[FuncIdx].empty())
+    compileFunction(FuncIdx);
+  auto &Func = mFuncs[FuncIdx];
+  DRAGON_DEBUG(dbgs() << "[RUNTIME] Entering function `" << Func.getName() <<
+               "`.\n");
+  if (mFrames.size() + mTailCalls >= mMaxCallDepth)
+    throw InterpreterException("Maximum call depth of " +
+        std::to_string(mMaxCallDepth) + " exceeded by call to function `" +
+        Func.getName() + "` at " + Token::posToString(PI));
+  auto ParamCount = Func.getParamCount();
+  if (ParamCount > mStack.size())
+    throw InterpreterException("Not enough arguments for function `" +
+        Func.getName() + "` at " + Token::posToString(PI));
+  // Global variables occupy the bottom of the slot stack, every other frame
+  // is placed right above its caller.
+  std::size_t Base = 0;
+  if (&Func != &mGlobalFunc)
+    Base = mFrames.empty() ? mGlobalFunc.getFrameSize() :
+        mFrames.back().Base + mFrames.back().Func->getFrameSize();
+  auto Top = Base + Func.getFrameSize();
+  if (Top > mSlots.size())
+    mSlots.resize(std::max(Top, mSlots.size() * 2));
+  std::transform(mStack.end() - ParamCount, mStack.end(),
+                 mSlots.begin() + Base,
+                 [this](const Value &Arg) { return makeOwned(Arg); });
+  mStack.resize(mStack.size() - ParamCount);
+  mFrames.push_back({ &Func, mCode[FuncIdx].data(), Base, 0, markTemps() });
+}
+
+void Interpreter::popFrame() {
+  auto &Top = mFrames.back();
+  DRAGON_DEBUG(dbgs() << "[RUNTIME] Leaving function `" <<
+               Top.Func->getName() << "`.\n");
+  // Slots above the innermost frame are always nil, so a reused frame starts
+  // out clean.
+  if (Top.Func != &mGlobalFunc) {
+    auto Begin = mSlots.begin() + Top.Base;
+    std::for_each(Begin, Begin + Top.Func->getFrameSize(),
+                  [this](Value &Var) { releaseOwned(Var); });
+  }
+  mTailCalls -= Top.TailCalls;
+  mFrames.pop_back();
+}
+
+void Interpreter::execute(std::size_t FuncIdx, const PosInfo &PI) {
+  auto EntryDepth = mFrames.size();
+  pushFrame(FuncIdx, PI);
+  // State of the innermost frame is cached in locals and reloaded on every
+  // call and return.
+  const CompiledFunction *F;
+  Instruction *Code;
+  std::size_t PC;
+  Value *Locals;
+  Value *Globals;
+  TempMark FrameMark;
+#define ENTER_TOP_FRAME() do { \
+    auto &Top = mFrames.back(); \
+    F = Top.Func; \
+    Code = Top.Code; \
+    PC = Top.PC; \
+    Globals = mSlots.data(); \
+    Locals = Globals + Top.Base; \
+    FrameMark = Top.Mark; \
+  } while (0)
+  ENTER_TOP_FRAME();
+  // Temporaries of a statement are dropped once the operand stack of the
+  // frame is empty again: on statement-level pop, jumps and return. A
+  // returned string stays alive until the caller's statement ends.
+  auto checkDefined = [](const Value &Var, const std::string &Name,
+                         const PosInfo &PI) {
+    if (Var.isNil())
+      throw InterpreterException("Variable with name `" + Name + "` used at " +
+          Token::posToString(PI) + " does not exist in this scope");
+  };
+  for (;;) {
+    auto &I = Code[PC++];
+    DRAGON_DEBUG(dbgs() << "[RUNTIME] Executing `" << opcodeToString(I.Op) <<
+                 "` at " << PC - 1 << ".\n");
+    switch (I.Op) {
+    case Opcode::PUSH_CONST:
+      mStack.push_back(F->getConstant(I.A));
+      break;
+    case Opcode::LOAD:
+      checkDefined(Locals[I.A], F->getLocalName(I.A), F->getPosInfo(PC - 1));
+      mStack.push_back(load(Locals[I.A]));
       break;
-    case Kind::PRINTLN:
-      std::cout << Int->getValue() << "\n";
+    case Opcode::STORE:
+      if (mStack.back().hasObject() || Locals[I.A].hasObject()) {
+        auto Stored = makeOwned(mStack.back());
+        releaseOwned(Locals[I.A]);
+        Locals[I.A] = Stored;
+      } else {
+        Locals[I.A] = mStack.back();
+      }
       break;
-    case Kind::PRINT:
-      std::cout << Int->getValue();
+    case Opcode::LOAD_GLOBAL:
+      checkDefined(Globals[I.A], mGlobalFunc.getLocalName(I.A),
+                   F->getPosInfo(PC - 1));
+      mStack.push_back(load(Globals[I.A]));
       break;
-    default:
-      throw InterpreterException("Unexpected unary operator for constant " +
-                                 Int->getPos());
-    }
-  } else if (auto FloatPtr = dynamic_cast<Float *>(Top)) {
-    switch (Op->getKind()) {
-    case Kind::UNARY_MINUS:
-      FloatPtr->setValue(-FloatPtr->getValue());
+    case Opcode::STORE_GLOBAL:
+      if (mStack.back().hasObject() || Globals[I.A].hasObject()) {
+        auto Stored = makeOwned(mStack.back());
+        releaseOwned(Globals[I.A]);
+        Globals[I.A] = Stored;
+      } else {
+        Globals[I.A] = mStack.back();
+      }
       break;
-    case Kind::PRINTLN:
-      std::cout << FloatPtr->getValue() << "\n";
+    case Opcode::POP:
+      mStack.pop_back();
+      releaseTemps(FrameMark);
       break;
-    case Kind::PRINT:
-      std::cout << FloatPtr->getValue();
+    case Opcode::GLOBAL:
+      if (Globals[I.A].isNil())
+        throw InterpreterException("Failed to find global variable at " +
+                                   Token::posToString(F->getPosInfo(PC - 1)));
+      break;
+    case Opcode::CALL:
+      mFrames.back().PC = PC;
+      pushFrame(I.A, F->getPosInfo(PC - 1));
+      ENTER_TOP_FRAME();
+      break;
+    case Opcode::CALL_NATIVE: {
+      auto &Native = getBuiltin(I.A);
+      auto Args = mStack.size() - Native.ParamCount;
+      auto Res = Native.Call(*this, mStack.data() + Args,
+                             F->getPosInfo(PC - 1));
+      mStack.resize(Args);
+      mStack.push_back(Res);
       break;
-    default:
-      throw InterpreterException("Unexpected unary operator for constant " +
-                                 FloatPtr->getPos());
     }
-  } else if (auto Str = dynamic_cast<String *>(Top)) {
-    switch (Op->getKind()) {
-    case Kind::PRINTLN:
-      std::cout << Str->getValue() << "\n";
+    case Opcode::TAIL_CALL: {
+      // The callee takes over the slots and the arena mark of the current
+      // frame and returns straight to its caller. The replaced frame still
+      // counts against the call depth, a function body cannot end a cycle
+      // of tail calls by itself.
+      auto PI = F->getPosInfo(PC - 1);
+      auto TailCalls = mFrames.back().TailCalls + 1;
+      popFrame();
+      mTailCalls += TailCalls;
+      pushFrame(I.A, PI);
+      mFrames.back().TailCalls = TailCalls;
+      mFrames.back().Mark = FrameMark;
+      releaseTemps(FrameMark);
+      ENTER_TOP_FRAME();
       break;
-    case Kind::PRINT:
-      std::cout << Str->getValue();
+    }
+    case Opcode::RET:
+    case Opcode::RET_VOID: {
+      // The returned value is already on top of the operand stack.
+      bool HasValue = I.Op == Opcode::RET;
+      if (!HasValue)
+        releaseTemps(FrameMark);
+      popFrame();
+      if (mFrames.size() == EntryDepth) {
+        if (HasValue)
+          mStack.pop_back();
+        return;
+      }
+      ENTER_TOP_FRAME();
+      auto &Call = Code[PC - 1];
+      if (!Call.B) {
+        if (HasValue)
+          mStack.pop_back();
+      } else if (!HasValue) {
+        throw InterpreterException("Function `" + mFuncs[Call.A].getName() +
+            "` called at " + Token::posToString(F->getPosInfo(PC - 1)) +
+            " does not return a value");
+      }
       break;
-    default:
-      throw InterpreterException("Unexpected unary operator for literal " +
-                                 FloatPtr->getPos());
     }
-  } else if (auto Bool = dynamic_cast<Boolean *>(Top)) {
-    switch (Op->getKind()) {
-    case Kind::PRINTLN:
-      std::cout << (Bool->getValue() ? "true" : "false")  << "\n";
+    case Opcode::JMP:
+      releaseTemps(FrameMark);
+      PC = I.A;
       break;
-    case Kind::PRINT:
-      std::cout << (Bool->getValue() ? "true" : "false");
+    case Opcode::JMP_IF: {
+      auto &Cond = mStack.back();
+      if (!Cond.isBool())
+        throw InterpreterException("Boolean expected for goto at " +
+                                   Token::posToString(F->getPosInfo(PC - 1)));
+      if (Cond.getBool())
+        PC = I.A;
+      mStack.pop_back();
+      releaseTemps(FrameMark);
       break;
-    case Kind::LOGICAL_NOT:
-      Bool->setValue(!Bool->getValue());
+    }
+    case Opcode::JMP_IF_FALSE: {
+      // Only produced from a negation followed by JMP_IF, so a non-boolean
+      // condition is reported as the negation would report it.
+      auto &Cond = mStack.back();
+      if (!Cond.isBool())
+        throw InterpreterException(
+            "Unexpected operand type for unary operator " +
+            Token::posToString(F->getPosInfo(PC - 1)));
+      if (!Cond.getBool())
+        PC = I.A;
+      mStack.pop_back();
+      releaseTemps(FrameMark);
       break;
-    default:
-      throw InterpreterException("Unexpected unary operator for boolean " +
-                                 Bool->getPos());
     }
-  } else {
-    throw InterpreterException("Unexpected operand type for unary operator " +
-                                Op->getPos());
-  }
-}
-
-Token *Interpreter::processBinary(
-    const BinaryOperator *Op, Token *OpLeftToken, Token *OpRightToken) {
-  DRAGON_DEBUG(dbgs() << "[RUNTIME] Processing binary operation `" <<
-               Op->kindToString() << "` for tokens: " <<
-               OpLeftToken->toString() << ", " <<
-               OpRightToken->toString() << ".\n");
-  auto CheckIdentifier = [this, Op](Token *Operand)->Constant * {
-    if (auto Id = dynamic_cast<Identifier *>(Operand)) {
-      auto ConstItrPair = getVarItr(Id);
-      if (ConstItrPair.first != ConstItrPair.second->end())
-        return ConstItrPair.first->second;
-      throw InterpreterException("Variable with name `" + Id->getName() +
-                                  "` does not exist in this scope at " +
-                                  Op->getPos());
-    } else if (auto Const = dynamic_cast<Constant *>(Operand)) {
-      return Const;
+    case Opcode::INC_LOCAL: {
+      auto &Var = Locals[I.A];
+      auto &Inc = F->getConstant(I.B);
+      std::int64_t Sum;
+      if (Var.isInt() && Inc.isInt() &&
+          !__builtin_add_overflow(Var.getInt(), Inc.getInt(), &Sum)) {
+        Var = Value(Sum);
+        PC += getFusedLength(Opcode::INC_LOCAL);
+      }
+      break;
     }
-    throw InterpreterException("Invalid operands for binary operation " +
-                               Op->getPos());
-  };
-  Constant *OpLeft = CheckIdentifier(OpLeftToken);
-  Constant *OpRight = CheckIdentifier(OpRightToken);
-  DRAGON_DEBUG(dbgs() << "[RUNTIME] Got constant values: " <<
-               OpLeft->toString() << " " << OpRight->toString() << "\n");
-  Integer *Int1, *Int2;
-  Float *F1, *F2;
-  Boolean *B1, *B2;
-  String *S1, *S2;
-  bool Res;
-  auto OpKind = Op->getKind();
-
-  switch (Op->getKind()) {
-  case Kind::LOGICAL_AND:
-  case Kind::LOGICAL_OR:
-    B1 = dynamic_cast<Boolean *>(OpLeft);
-    B2 = dynamic_cast<Boolean *>(OpRight);
-    if (!B1 || !B2)
-      throw InterpreterException("Type mismatch for logical or.");
-    Res = Op->getKind() == Kind::LOGICAL_OR ?
-        (B1->getValue() || B2->getValue()) :
-        (B1->getValue() && B2->getValue());
-    return new Boolean(Res);
-  case Kind::BITWISE_AND:
-  case Kind::BITWISE_OR:
-  case Kind::BITWISE_XOR:
-  case Kind::SHL:
-  case Kind::SHR:
-  case Kind::MODULE:
-    Int1 = dynamic_cast<Integer *>(OpLeft);
-    Int2 = dynamic_cast<Integer *>(OpRight);
-    if (!Int1 || !Int2)
-      throw InterpreterException("Type mismatch for bitwise operation.");
-    if (OpKind == Kind::BITWISE_AND)
-      return new Integer(Int1->getValue() & Int2->getValue());
-    else if (OpKind == Kind::BITWISE_OR)
-      return new Integer(Int1->getValue() | Int2->getValue());
-    else if (OpKind == Kind::SHL)
-      return new Integer(Int1->getValue() << Int2->getValue());
-    else if (OpKind == Kind::SHR)
-      return new Integer(Int1->getValue() >> Int2->getValue());
-    else if (OpKind == Kind::MODULE)
-      return new Integer(Int1->getValue() % Int2->getValue());
-    else
-      return new Integer(Int1->getValue() ^ Int2->getValue());
-    assert(0);
-  default:
-    Int1 = dynamic_cast<Integer *>(OpLeft);
-    Int2 = dynamic_cast<Integer *>(OpRight);
-    if (Int1 && Int2) {
-      if (OpKind == Kind::EQUAL)
-        return new Boolean(Int1->getValue() == Int2->getValue());
-      else if (OpKind == Kind::NOT_EQUAL)
-        return new Boolean(Int1->getValue() != Int2->getValue());
-      else if (OpKind == Kind::LESS)
-        return new Boolean(Int1->getValue() < Int2->getValue());
-      else if (OpKind == Kind::LEQ)
-        return new Boolean(Int1->getValue() <= Int2->getValue());
-      else if (OpKind == Kind::GREATER)
-        return new Boolean(Int1->getValue() > Int2->getValue());
-      else if (OpKind == Kind::GEQ)
-        return new Boolean(Int1->getValue() >= Int2->getValue());
-      else if (OpKind == Kind::PLUS)
-        return new Integer(Int1->getValue() + Int2->getValue());
-      else if (OpKind == Kind::MINUS)
-        return new Integer(Int1->getValue() - Int2->getValue());
-      else if (OpKind == Kind::MULTIPLY)
-        return new Integer(Int1->getValue() * Int2->getValue());
-      else if (OpKind == Kind::DIVIDE)
-        return new Float(Int1->getValue() / double(Int2->getValue()));
-      assert(0);
+    case Opcode::CMP_JMP_LOCAL:
+    case Opcode::CMP_JMP_CONST: {
+      auto &Right = I.Op == Opcode::CMP_JMP_LOCAL ? Locals[I.B] :
+                                                    F->getConstant(I.B);
+      Value Res;
+      if (processNumeric(getGenericOpcode(Code[PC + 2].Op), Locals[I.A],
+                         Right, Res)) {
+        auto &Jump = Code[PC + 3];
+        if (Res.getBool() == (Jump.Op == Opcode::JMP_IF))
+          PC = Jump.A;
+        else
+          PC += getFusedLength(Opcode::CMP_JMP_LOCAL);
+      }
+      break;
+    }
+    case Opcode::BINARY_LOCAL:
+    case Opcode::BINARY_CONST: {
+      auto &Right = I.Op == Opcode::BINARY_LOCAL ? Locals[I.B] :
+                                                   F->getConstant(I.B);
+      auto &Dest = Locals[Code[PC + 3].A];
+      if (!Dest.hasObject() &&
+          processNumeric(getGenericOpcode(Code[PC + 2].Op), Locals[I.A],
+                         Right, Dest))
+        PC += getFusedLength(Opcode::BINARY_LOCAL);
+      break;
     }
-    F1 = dynamic_cast<Float *>(OpLeft);
-    F2 = dynamic_cast<Float *>(OpRight);
-    if (F1 && F2) {
-      if (OpKind == Kind::EQUAL)
-        return new Boolean(F1->getValue() == F2->getValue());
-      else if (OpKind == Kind::NOT_EQUAL)
-        return new Boolean(F1->getValue() != F2->getValue());
-      else if (OpKind == Kind::LESS)
-        return new Boolean(F1->getValue() < F2->getValue());
-      else if (OpKind == Kind::LEQ)
-        return new Boolean(F1->getValue() <= F2->getValue());
-      else if (OpKind == Kind::GREATER)
-        return new Boolean(F1->getValue() > F2->getValue());
-      else if (OpKind == Kind::GEQ)
-        return new Boolean(F1->getValue() >= F2->getValue());
-      else if (OpKind == Kind::PLUS)
-        return new Float(F1->getValue() + F2->getValue());
-      else if (OpKind == Kind::MINUS)
-        return new Float(F1->getValue() - F2->getValue());
-      else if (OpKind == Kind::MULTIPLY)
-        return new Float(F1->getValue() * F2->getValue());
-      else if (OpKind == Kind::DIVIDE)
-        return new Float(F1->getValue() / F2->getValue());
-      assert(0);
+    case Opcode::INDEX_LOCAL: {
+      auto &Array = Locals[I.A], &Index = Locals[I.B];
+      if (Array.isArray() && Index.isInt() &&
+          static_cast<std::uint64_t>(Index.getInt()) <
+          Array.getArrayLength()) {
+        mStack.push_back(Array.getElement(Index.getInt()));
+        PC += getFusedLength(Opcode::INDEX_LOCAL);
+      }
+      break;
+    }
+    case Opcode::STORE_INDEX_LOCAL: {
+      auto &Array = Locals[I.A], &Index = Locals[I.B];
+      if (Array.isArray() && Index.isInt() &&
+          static_cast<std::uint64_t>(Index.getInt()) <
+          Array.getArrayLength() &&
+          Array.setElement(Index.getInt(), mStack.back()))
+        PC += getFusedLength(Opcode::STORE_INDEX_LOCAL);
+      break;
     }
-    S1 = dynamic_cast<String *>(OpLeft);
-    S2 = dynamic_cast<String *>(OpRight);
-    if (S1 && S2) {
-      if (OpKind == Kind::EQUAL)
-        return new Boolean(S1->getValue() == S2->getValue());
-      else if (OpKind == Kind::NOT_EQUAL)
-        return new Boolean(S1->getValue() != S2->getValue());
-      else if (OpKind == Kind::PLUS)
-        return new String(S1->getValue() + S2->getValue());
+    case Opcode::MAKE_ARRAY:
+      makeArray(I.A, F->getPosInfo(PC - 1));
+      break;
+    case Opcode::LOAD_INDEX: {
+      // The array itself stays alive through the reference taken by its load.
+      auto Index = mStack.back();
+      mStack.pop_back();
+      auto &Array = mStack.back();
+      if (Array.isDict())
+        Array = load(findKey(Array.getDict(), Index, F->getPosInfo(PC - 1)));
       else
-        throw InterpreterException("It is forbidden to compare strings");
+        Array = Array.getElement(checkIndex(Array, Index,
+                                            F->getPosInfo(PC - 1)));
+      break;
     }
-    B1 = dynamic_cast<Boolean *>(OpLeft);
-    B2 = dynamic_cast<Boolean *>(OpRight);
-    if (B1 && B2) {
-      bool Res;
-      if (OpKind == Kind::EQUAL)
-        Res = S1->getValue() == S2->getValue();
-      else if (OpKind == Kind::NOT_EQUAL)
-        Res = S1->getValue() != S2->getValue();
+    case Opcode::STORE_INDEX: {
+      auto &PI = F->getPosInfo(PC - 1);
+      auto Index = mStack.back();
+      mStack.pop_back();
+      auto Array = mStack.back();
+      mStack.pop_back();
+      if (Array.isDict())
+        storeKey(Array.getDict(), Index, mStack.back(), PI);
       else
-        throw InterpreterException("It is forbidden to compare bools");
-      return new Boolean(Res);
+        storeElement(Array, checkIndex(Array, Index, PI), mStack.back(), PI);
+      break;
     }
-    if (Int1 && F2) {
-      if (OpKind == Kind::EQUAL)
-        return new Boolean(Int1->getValue() == F2->getValue());
-      else if (OpKind == Kind::NOT_EQUAL)
-        return new Boolean(Int1->getValue() != F2->getValue());
-      else if (OpKind == Kind::LESS)
-        return new Boolean(Int1->getValue() < F2->getValue());
-      else if (OpKind == Kind::LEQ)
-        return new Boolean(Int1->getValue() <= F2->getValue());
-      else if (OpKind == Kind::GREATER)
-        return new Boolean(Int1->getValue() > F2->getValue());
-      else if (OpKind == Kind::GEQ)
-        return new Boolean(Int1->getValue() >= F2->getValue());
-      else if (OpKind == Kind::PLUS)
-        return new Float(Int1->getValue() + F2->getValue());
-      else if (OpKind == Kind::MINUS)
-        return new Float(Int1->getValue() - F2->getValue());
-      else if (OpKind == Kind::MULTIPLY)
-        return new Float(Int1->getValue() * F2->getValue());
-      else if (OpKind == Kind::DIVIDE)
-        return new Float(Int1->getValue() / double(F2->getValue()));
-      assert(0);
+    case Opcode::DELETE_INDEX: {
+      auto &PI = F->getPosInfo(PC - 1);
+      auto Key = mStack.back();
+      mStack.pop_back();
+      auto Target = mStack.back();
+      mStack.pop_back();
+      if (!Target.isDict())
+        throw InterpreterException("Dict expected for `delete` at " +
+                                   Token::posToString(PI));
+      auto &D = Target.getDict();
+      if (!D.erase(Key, hashKey(Key, PI)))
+        throwMissingKey(Key, PI);
+      releaseTemps(FrameMark);
+      break;
     }
-    if (F1 && Int2) {
-      if (OpKind == Kind::EQUAL)
-        return new Boolean(F1->getValue() == Int2->getValue());
-      else if (OpKind == Kind::NOT_EQUAL)
-        return new Boolean(F1->getValue() != Int2->getValue());
-      else if (OpKind == Kind::LESS)
-        return new Boolean(F1->getValue() < Int2->getValue());
-      else if (OpKind == Kind::LEQ)
-        return new Boolean(F1->getValue() <= Int2->getValue());
-      else if (OpKind == Kind::GREATER)
-        return new Boolean(F1->getValue() > Int2->getValue());
-      else if (OpKind == Kind::GEQ)
-        return new Boolean(F1->getValue() >= Int2->getValue());
-      else if (OpKind == Kind::PLUS)
-        return new Float(F1->getValue() + Int2->getValue());
-      else if (OpKind == Kind::MINUS)
-        return new Float(F1->getValue() - Int2->getValue());
-      else if (OpKind == Kind::MULTIPLY)
-        return new Float(F1->getValue() * Int2->getValue());
-      else if (OpKind == Kind::DIVIDE)
-        return new Float(F1->getValue() / double(Int2->getValue()));
-      assert(0);
+    case Opcode::SLICE: {
+      auto High = mStack.back();
+      mStack.pop_back();
+      auto Low = mStack.back();
+      mStack.pop_back();
+      mStack.back() = sliceArray(mStack.back(), Low, High,
+                                 F->getPosInfo(PC - 1));
+      break;
     }
-    throw InterpreterException("Type mismatch for binary operation at " +
-        Op->getPos());
-  }
-
-}
-
-void Interpreter::processBinaryGoto(
-    Token *OpLeft, Token *OpRight, std::size_t &Idx) {
-  if (auto Id = dynamic_cast<Identifier *>(OpLeft)) {
-    auto VarItr = getVarItr(Id);
-    auto Bool = dynamic_cast<Boolean *>(VarItr.first->second);
-    if (!Bool)
-      throw InterpreterException("Boolean expected for goto at " +
-                                OpLeft->getPos());
-    OpLeft = Bool;
-  }
-  if (auto Bool = dynamic_cast<Boolean *>(OpLeft)) {
-    if (auto Int = dynamic_cast<Integer *>(OpRight)) {
-      if (Bool->getValue()) {
-        Idx = Int->getValue() - 1;
+    case Opcode::FOR_PREP: {
+      // The loop holds on to the iterable, whatever happens to the variable
+      // it came from.
+      auto &Iterable = mStack.back();
+      if (!Iterable.isArray() && !Iterable.isDict())
+        throw InterpreterException("Only arrays and dicts can be iterated at " +
+                                   Token::posToString(F->getPosInfo(PC - 1)));
+      releaseOwned(Locals[I.A]);
+      Locals[I.A] = makeOwned(Iterable);
+      Locals[I.A + 1] = Value(std::int64_t(0));
+      mStack.pop_back();
+      releaseTemps(FrameMark);
+      break;
+    }
+    case Opcode::FOR_NEXT: {
+      // Arrays give their elements and dicts their keys, in insertion order.
+      // Keys erased during the loop are skipped.
+      auto &Iterable = Locals[I.B];
+      std::size_t Pos = Locals[I.B + 1].getInt();
+      if (Iterable.isArray()) {
+        if (Pos < Iterable.getArrayLength()) {
+          mStack.push_back(Iterable.getElement(Pos));
+          Locals[I.B + 1] = Value(std::int64_t(Pos + 1));
+          break;
+        }
+      } else {
+        auto &D = Iterable.getDict();
+        while (Pos < D.getEntryCount() && D.getEntry(Pos).Key.isNil())
+          ++Pos;
+        if (Pos < D.getEntryCount()) {
+          mStack.push_back(load(D.getEntry(Pos).Key));
+          Locals[I.B + 1] = Value(std::int64_t(Pos + 1));
+          break;
+        }
       }
-    } else {
-      throw InterpreterException("Integer position expected for goto at " +
-                                OpLeft->getPos());
+      releaseOwned(Iterable);
+      PC = I.A;
+      break;
     }
-  } else {
-    throw InterpreterException("Boolean expected for goto at " +
-                                OpLeft->getPos());
-  }
-}
-
-void Interpreter::processAssign(Token *OpLeft, Token *OpRight) {
-  DRAGON_DEBUG(dbgs() << "[RUNTIME] Processing assignment for tokens: " <<
-               OpLeft->toString() << ", " << OpRight->toString() << ".\n");
-  if (auto Id = dynamic_cast<Identifier *>(OpLeft)) {
-    auto ItrPair = getVarItr(Id, false);
-    Constant **Value = nullptr;
-    if (ItrPair.first == ItrPair.second->end()) {
-      DRAGON_DEBUG(
-          dbgs() << "[RUNTIME] Create new table entry for left operand.\n");
-      Value = &ItrPair.second->insert(std::make_pair(
-          Id->getName(), nullptr)).first->second;
-    } else {
-      DRAGON_DEBUG(
-          dbgs() << "[RUNTIME] Use existing table entry for left operand.\n");
-      Value = &ItrPair.first->second;
+    case Opcode::POS:
+    case Opcode::NEG:
+    case Opcode::NOT:
+    case Opcode::LEN:
+      mStack.back() = processUnary(I.Op, mStack.back(), F->getPosInfo(PC - 1),
+                                   mArena);
+      break;
+    case Opcode::PRINT:
+    case Opcode::PRINTLN:
+      processPrint(mStack.back(), I.Op == Opcode::PRINTLN,
+                   F->getPosInfo(PC - 1));
+      break;
+#define QUICK_BINARY(OP, GUARD, GET, EXPR) \
+    case Opcode::OP: { \
+      auto &Left = mStack[mStack.size() - 2], &Right = mStack.back(); \
+      if (GUARD) { \
+        auto L = Left.GET(), R = Right.GET(); \
+        Left = Value(EXPR); \
+        mStack.pop_back(); \
+      } else { \
+        deoptimize(I); \
+        --PC; \
+      } \
+      break; \
+    }
+// Integer arithmetic that may overflow. An overflow sends the site back to
+// the generic operator, which promotes the result.
+#define CHECKED_BINARY(OP, BUILTIN) \
+    case Opcode::OP: { \
+      auto &Left = mStack[mStack.size() - 2], &Right = mStack.back(); \
+      std::int64_t Res; \
+      if (INT_GUARD && !BUILTIN(Left.getInt(), Right.getInt(), &Res)) { \
+        Left = Value(Res); \
+        mStack.pop_back(); \
+      } else { \
+        deoptimize(I); \
+        --PC; \
+      } \
+      break; \
+    }
+#define INT_GUARD (Left.isInt() && Right.isInt())
+#define FLOAT_GUARD (Left.isNumber() && Right.isNumber() && \
+                     (Left.isFloat() || Right.isFloat()))
+    CHECKED_BINARY(ADD_INT, __builtin_add_overflow)
+    CHECKED_BINARY(SUB_INT, __builtin_sub_overflow)
+    CHECKED_BINARY(MUL_INT, __builtin_mul_overflow)
+    QUICK_BINARY(MOD_INT, INT_GUARD && Right.getInt() != 0 &&
+                 Right.getInt() != -1, getInt, L % R)
+    QUICK_BINARY(EQ_INT, INT_GUARD, getInt, L == R)
+    QUICK_BINARY(NE_INT, INT_GUARD, getInt, L != R)
+    QUICK_BINARY(LT_INT, INT_GUARD, getInt, L < R)
+    QUICK_BINARY(LE_INT, INT_GUARD, getInt, L <= R)
+    QUICK_BINARY(GT_INT, INT_GUARD, getInt, L > R)
+    QUICK_BINARY(GE_INT, INT_GUARD, getInt, L >= R)
+    QUICK_BINARY(ADD_FLOAT, FLOAT_GUARD, getNumber, L + R)
+    QUICK_BINARY(SUB_FLOAT, FLOAT_GUARD, getNumber, L - R)
+    QUICK_BINARY(MUL_FLOAT, FLOAT_GUARD, getNumber, L * R)
+    QUICK_BINARY(DIV_FLOAT, FLOAT_GUARD, getNumber, L / R)
+    QUICK_BINARY(LT_FLOAT, FLOAT_GUARD, getNumber, L < R)
+    QUICK_BINARY(LE_FLOAT, FLOAT_GUARD, getNumber, L <= R)
+    QUICK_BINARY(GT_FLOAT, FLOAT_GUARD, getNumber, L > R)
+    QUICK_BINARY(GE_FLOAT, FLOAT_GUARD, getNumber, L >= R)
+#undef FLOAT_GUARD
+#undef INT_GUARD
+#undef CHECKED_BINARY
+#undef QUICK_BINARY
+    default: {
+      auto OpRight = mStack.back();
+      mStack.pop_back();
+      auto Op = I.Op;
+      recordFeedback(I, mStack.back(), OpRight);
+      auto &Left = mStack.back();
+      if (Op == Opcode::IN && OpRight.isDict())
+        Left = Value(OpRight.getDict().find(
+            Left, hashKey(Left, F->getPosInfo(PC - 1))) != nullptr);
+      else if (Left.isArray() || OpRight.isArray())
+        Left = processArray(Op, Left, OpRight, F->getPosInfo(PC - 1));
+      else if (Op == Opcode::ADD && OpRight.isString() &&
+               Left.isStringObject() &&
+               Left.getStringObject()->isCounted())
+        Left = appendString(Left, OpRight.getString(), F->getPosInfo(PC - 1));
+      else
+        Left = processBinary(Op, Left, OpRight, F->getPosInfo(PC - 1),
+                             mArena);
+      break;
     }
-    if (auto ConstRight = dynamic_cast<Constant *>(OpRight)) {
-      *Value = ConstRight->cloneConst();
-    } else if (auto IdRight = dynamic_cast<Identifier *>(OpRight)) {
-      auto RightItr = getVarItr(IdRight);
-      if (RightItr.first == RightItr.second->end())
-        throw InterpreterException("Failed to read variable `" +
-            IdRight->getName() + "` at " + OpLeft->getPos());
-      *Value = RightItr.first->second->cloneConst();
-    } else {
-      throw InterpreterException("Non-constant right expression at " +
-                                OpLeft->getPos());
     }
-    DRAGON_DEBUG(dbgs() << "[RUNTIME] New token for a value of left operand: "
-                 << (*Value)->toString() << "\n");
-    if (ItrPair.second == &mVarTableStack.back())
-      mTmpTokens.back().insert(*Value);
-    else
-      mTmpTokens.front().insert(*Value);
-  } else {
-    throw InterpreterException("R-value error at " +
-                                OpLeft->getPos());
   }
+#undef ENTER_TOP_FRAME
 }
 
-bool Interpreter::run(const Function &F) {
-  auto &PL = F.getPostfixList();
-  for (std::size_t Idx = 0; Idx < PL.size(); ++Idx) {
-    std::stack<Token *> Stack;
-    for (auto Itr = PL[Idx].begin(); Itr != PL[Idx].end(); ++Itr) {
-      DRAGON_DEBUG(dbgs() << "[RUNTIME] Checking token " << (*Itr)->toString()
-                   << ".\n");
-      auto Token = *Itr;
-      if (dynamic_cast<Constant *>(Token)) {
-        Stack.push(Token);
-      } else if (auto Id = dynamic_cast<Identifier *>(Token)) {
-        auto FuncItr = mFM.find(Id->getName());
-        if (FuncItr == mFM.end()) {
-          Stack.push(Token);
-        } else {
-          auto ParamCount = FuncItr->second.getParamList().size();
-          for (std::size_t I = 0; I < ParamCount; ++I) {
-            if (Stack.empty())
-              throw InterpreterException("Not enough arguments for function at "
-                                        + Id->getPos());
-            auto ArgToken = Stack.top();
-            Constant *ConstValue = nullptr;
-            if (auto ArgId = dynamic_cast<Identifier *>(ArgToken)) {
-              auto VarItr = getVarItr(ArgId);
-              DRAGON_DEBUG(dbgs() << "[RUNTIME] Add variable to call stack: "
-                           << VarItr.first->second->toString() << "\n");
-              ConstValue = VarItr.first->second->cloneConst();
-            } else if (auto Const = dynamic_cast<Constant *>(ArgToken)) {
-              ConstValue = Const->cloneConst();
-            } else {
-              throw InterpreterException("Invalid argument type at " +
-                                         ArgToken->getPos());
-            }
-            mCallStack.push(ConstValue);
-            Stack.pop();
-          }
-          auto HasReturned = callFunction(FuncItr->second.getName());
-          if (HasReturned) {
-            auto RetConst = mCallStack.top();
-            mTmpTokens.front().insert(RetConst);
-            Stack.push(RetConst);
-          }
-        }
-      } else if (auto Kw = dynamic_cast<Keyword *>(Token)) {
-        if (Stack.empty() && Kw->getKind() != Kind::RETURN)
-          throw InterpreterException("Unexpected unary operator at " +
-                                     Kw->getPos());
-        if (auto Unary = dynamic_cast<PrefixOperator *>(Kw)) {
-          if (Unary->getKind() == Kind::GLOBAL) {
-            if (Stack.empty())
-              throw InterpreterException("Not enough arguments for `global` at "
-                                         + Unary->getPos());
-            auto Id = dynamic_cast<Identifier *>(Stack.top());
-            if (!Id)
-              throw InterpreterException("Not an identifier after `global` at "
-                                         + Unary->getPos());
-            auto &GlobalTable = mVarTableStack.back();
-            auto GlobItr = GlobalTable.find(Id->getName());
-            if (GlobItr == GlobalTable.end())
-              throw InterpreterException("Failed to find global variable at "
-                                         + Unary->getPos());
-            mGlobVarSetStack.front().insert(Id->getName());
-            Stack.pop();
-            continue;
-          }
-          if (Unary->getKind() == Kind::RETURN) {
-            if (Stack.empty()) {
-              return false;
-            } else {
-              auto Top = Stack.top();
-              Constant *RetConst = nullptr;
-              if (auto Id = dynamic_cast<Identifier *>(Top)) {
-                RetConst = getVarItr(Id).first->second->cloneConst();
-              } else if (auto Const = dynamic_cast<Constant *>(Top)) {
-                RetConst = Const->cloneConst();
-              } else {
-                throw InterpreterException(
-                    "Unexpected kind of returning value at " + Kw->getPos());
-              }
-              mCallStack.push(RetConst);
-              return true;
-            }
-          } else if (Unary->getKind() == Kind::GOTO_UN) {
-            if (auto Int = dynamic_cast<Integer *>(Stack.top())) {
-              Idx = Int->getValue() - 1;
-            } else {
-              throw InterpreterException("Non-integer goto found");
-            }
-            break;
-          } else {
-            processUnary(Unary, Stack.top());
-          }
-        } else if (auto Binary = dynamic_cast<BinaryOperator *>(Kw)) {
-          if (Stack.size() < 2)
-            throw InterpreterException("Not enough operands at " + Kw->getPos());
-          auto OpRight = Stack.top();
-          Stack.pop();
-          auto OpLeft = Stack.top();
-          if (Binary->getKind() == Kind::GOTO_BIN) {
-            processBinaryGoto(OpLeft, OpRight, Idx);
-            Stack.pop();
-            break;
-          } else if (Binary->getKind() == Kind::ASSIGN) {
-            processAssign(OpLeft, OpRight);
-          } else {
-            auto Res = processBinary(Binary, OpLeft, OpRight);
-            Stack.pop();
-            mTmpTokens.front().insert(Res);
-            Stack.push(Res);
-          }
-        } else {
-          throw InterpreterException("Unexpected keyword `" +
-              Kw->kindToString() + "` at " + Kw->getPos());
-        }
-      } else {
-        throw InterpreterException("Unexpected token at " + Token->getPos());
-      }
-    }
-  }
-  return false;
+Interpreter::Interpreter(Compiler &C, OutputBuffer &Out,
+                         std::size_t MaxCallDepth)
+    : Interpreter(C.getFuncList(), &C, Out, MaxCallDepth) {}
+
+Interpreter::Interpreter(const FuncList &Funcs, OutputBuffer &Out,
+                         std::size_t MaxCallDepth)
+    : Interpreter(Funcs, nullptr, Out, MaxCallDepth) {}
+
+Interpreter::Interpreter(const FuncList &Funcs, Compiler *C,
+                         OutputBuffer &Out, std::size_t MaxCallDepth)
+    : mCompiler(C), mOut(Out), mFuncs(Funcs),
+      mGlobalFunc(mFuncs[*findFunction(GLOBAL_FUNC)]),
+      mSlots(mGlobalFunc.getFrameSize()), mMaxCallDepth(MaxCallDepth),
+      mStartMark(markTemps()) {
+  mCode.reserve(mFuncs.size());
+  for (auto &Func : mFuncs)
+    mCode.push_back(Func.getCode());
 }
 
-bool Interpreter::callFunction(const std::string &FName) {
-  DRAGON_DEBUG(dbgs() << "[RUNTIME] Entering function `" << FName << "`.\n");
-  auto Itr = mFM.find(FName);
-  if (Itr == mFM.end())
-    throw InterpreterException("Function with name `" + FName +
-                               "` does not exist");
-  auto &Func = Itr->second;
-  auto &ParamList = Func.getParamList();
-  if (ParamList.size() > mCallStack.size())
-    throw InterpreterException("Not enough arguments for function `" + FName +
-                               "`.");
-  auto &VarTable = mVarTableStack.emplace_front();
-  auto &CurTmp = mTmpTokens.emplace_front();
-  mGlobVarSetStack.emplace_front();
-  for (auto Itr = ParamList.rbegin(); Itr != ParamList.rend(); ++Itr) {
-    auto ParamConst = mCallStack.top()->cloneConst();
-    CurTmp.insert(ParamConst);
-    VarTable.insert(std::make_pair((*Itr)->getName(), ParamConst));
-    delete mCallStack.top();
-    mCallStack.pop();
+void Interpreter::run(const GlobalList &Globals) {
+  reset();
+  for (auto &Global : Globals) {
+    assert(Global.first < mGlobalFunc.getFrameSize() && "Not a global slot!");
+    mSlots[Global.first] = makeOwned(Global.second);
   }
-  mFuncStack.push(&Func);
-  auto HasReturned = run(Func);
-  if (FName != GLOBAL_FUNC) {
-    if (!mTmpTokens.empty()) {
-      for (auto Ptr : mTmpTokens.front())
-        delete Ptr;
-      mTmpTokens.pop_front();
-    }
-    mVarTableStack.pop_front();
-    mGlobVarSetStack.pop_front();
-  }
-  mFuncStack.pop();
-  DRAGON_DEBUG(dbgs() << "[RUNTIME] Leaving function `" << FName << "`.\n");
-  return HasReturned;
+  execute(*findFunction(GLOBAL_FUNC), PosInfo());
+  if (auto MainIdx = findFunction("main"))
+    execute(*MainIdx, PosInfo());
 }
 
-Interpreter::Interpreter(const SyntaxAnalyzer &SA) : mFM(SA.getFuncMap()) {
-  mCallStack.emplace();
-  callFunction(GLOBAL_FUNC);
-  if (mFM.find("main") != mFM.end()) {
-    callFunction("main");
-  }
-};
+// Drops whatever a previous run left behind, including the frames and
+// temporaries of one that was cut short by an error.
+void Interpreter::reset() {
+  mFrames.clear();
+  mTailCalls = 0;
+  mStack.clear();
+  releaseTemps(mStartMark);
+  for (auto &Var : mSlots)
+    releaseOwned(Var);
+  mRandom = Random();
+}
+
+// The first function declared with the name, as the analyzer resolves calls.
+std::optional<std::size_t> Interpreter::findFunction(
+    std::string_view Name) const {
+  for (std::size_t Idx = 0; Idx < mFuncs.size(); ++Idx)
+    if (mFuncs[Idx].getName() == Name)
+      return Idx;
+  return std::nullopt;
+}
 
 Interpreter::~Interpreter() {
-  while (!mTmpTokens.empty()) {
-    for (auto Ptr : mTmpTokens.front())
-      delete Ptr;
-    mTmpTokens.pop_front();
-  }
+  releaseTemps({ mArena.mark(), 0 });
+  for (auto &Var : mSlots)
+    releaseOwned(Var);
 }
\ No newline at end of file
@@ -1,73 +1,88 @@
 #include "dragon/analysis/LexicalAnalyzer.h"
+#include <charconv>
+#include <iterator>
 
-LexicalAnalyzer::LexicalAnalyzer(std::istream &IS) : mLineN(0) {
-  std::string Line;
-  int LineN = 0;
-  while (std::getline(IS, Line)) {
-    parseLine(Line);
-    ++LineN;
+LexicalAnalyzer::LexicalAnalyzer(std::istream &IS, ScanLevel Level)
+    : mScanner(Level), mBuffer(std::istreambuf_iterator<char>(IS),
+                               std::istreambuf_iterator<char>()) {
+  parseSource(mBuffer);
+}
+
+LexicalAnalyzer::LexicalAnalyzer(std::string_view Source, ScanLevel Level)
+    : mScanner(Level) {
+  parseSource(Source);
+}
+
+void LexicalAnalyzer::parseSource(std::string_view Source) {
+  const char *Ptr = Source.data();
+  const char *End = Ptr + Source.size();
+  while (Ptr != End) {
+    auto *LineEnd = mScanner.find(Ptr, End, '\n');
+    parseLine(std::string_view(Ptr, LineEnd - Ptr));
+    Ptr = LineEnd == End ? End : LineEnd + 1;
   }
   DRAGON_DEBUG(dbgs() << "[LEXICAL ANALYZER] Total line count: " <<
-               LineN << "\n");
+               mLineN << "\n");
   DRAGON_DEBUG(dump());
 }
 
-void LexicalAnalyzer::parseLine(const std::string &Line) {
-  CharBuffer Buffer(Line);
+void LexicalAnalyzer::parseLine(std::string_view Line) {
   ++mLineN;
   auto &TokenList = mTokens.emplace_back();
-  auto isNumberChar = [](const char &Ch) {
-    return std::isdigit(Ch) || Ch == '.';
+  const char *Begin = Line.data();
+  const char *End = Begin + Line.size();
+  auto getPos = [this, Begin](const char *Ptr) {
+    PosType ColN = Ptr - Begin + 1;
+    return std::make_pair(static_cast<PosType>(mLineN), ColN);
   };
-  auto getPos = [this, &Buffer](const CharBuffer::ConstIterator &Itr) {
-    auto ColN = Itr.getPtr() - Buffer.cbegin().getPtr() + 1;
-    return std::make_pair(mLineN, ColN);
+  auto getErrorPos = [&getPos](const char *Ptr) {
+    return Token::posToString(getPos(Ptr));
   };
-  auto getErrorPos = [this, &Buffer, &getPos](
-      const CharBuffer::ConstIterator &Itr) {
-    auto Pos = getPos(Itr);
-    return std::to_string(Pos.first) + ":" + std::to_string(Pos.second);
+  auto isCharAfterNumber = [](char Ch) {
+    return Keyword::isPunctChar(Ch) || Ch == '#' || Ch == ' ' || Ch == '\t';
   };
-  const std::string CharsAfterNumber = Keyword::getPunctStr() + "# \t\n";
-  for (auto Itr = Buffer.cbegin(); Itr != Buffer.cend(); ++Itr) {
-    auto WordBegin = Itr;
-    auto &Peek = *Itr;
-    if (std::isspace(Peek))
-      continue;
-    if (std::isdigit(Peek)) {
-      std::string NumStr { Peek };
-      auto Next = Buffer.lookAhead(Itr);
-      bool HasDot = false;
-      while (Next && isNumberChar(*Next)) {
-        if (HasDot && *Next == '.')
-          break;
-        NumStr += *Next;
-        ++Itr;
-        Next = Buffer.lookAhead(Itr);
-      }
-      if (Next && CharsAfterNumber.find(*Next) == std::string::npos)
+  // Every branch leaves Ptr at the last character of its token.
+  for (const char *Ptr = Begin; Ptr != End; ++Ptr) {
+    Ptr = mScanner.skipSpaces(Ptr, End);
+    if (Ptr == End)
+      break;
+    const char *WordBegin = Ptr;
+    char Peek = *Ptr;
+    if (CharScanner::is(Peek, CharScanner::DIGIT)) {
+      Ptr = mScanner.skipDigits(Ptr + 1, End);
+      bool HasDot = Ptr != End && *Ptr == '.';
+      if (HasDot)
+        Ptr = mScanner.skipDigits(Ptr + 1, End);
+      --Ptr;
+      if (Ptr + 1 != End && !isCharAfterNumber(Ptr[1]))
         throw ParserException("Invalid character after number at " +
-                              getErrorPos(Itr));
-      if (NumStr[0] == '.' && NumStr.size() == 1)
-        throw ParserException("Invalid number format at " + getErrorPos(Itr));
-      if (NumStr.find('.') == std::string::npos)
-        TokenList.push_back(std::make_unique<Integer>(std::stoi(NumStr),
-                            getPos(WordBegin)));
-      else
-        TokenList.push_back(std::make_unique<Float>(std::stod(NumStr),
-                            getPos(WordBegin)));
-    } else if (std::isalpha(Peek) || Peek == '_') {
-      std::string Word { Peek };
-      auto Next = Buffer.lookAhead(Itr);
-      while (Next && (std::isalnum(*Next) || *Next == '_')) {
-        Word += *Next;
-        ++Itr;
-        Next = Buffer.lookAhead(Itr);
+                              getErrorPos(Ptr));
+      std::from_chars_result Res;
+      if (!HasDot) {
+        std::int64_t Value;
+        Res = std::from_chars(WordBegin, Ptr + 1, Value);
+        if (Res.ec == std::errc())
+          TokenList.push_back(std::make_unique<Integer>(Value,
+                              getPos(WordBegin)));
+      } else {
+        double Value;
+        Res = std::from_chars(WordBegin, Ptr + 1, Value);
+        if (Res.ec == std::errc())
+          TokenList.push_back(std::make_unique<Float>(Value,
+                              getPos(WordBegin)));
       }
-      if (Keyword::isKeyword(Word)) {
-        if (Keyword::isForbiddenKeyword(Word))
-          throw ParserException("Forbidden keyword at " + getErrorPos(Itr));
-        Keyword::addDynamicKeyword(Word, TokenList, getPos(WordBegin));
+      if (Res.ec == std::errc::result_out_of_range)
+        throw ParserException("Number out of range at " +
+                              getErrorPos(WordBegin));
+      if (Res.ec != std::errc() || Res.ptr != Ptr + 1)
+        throw ParserException("Invalid number format at " + getErrorPos(Ptr));
+    } else if (CharScanner::is(Peek, CharScanner::WORD)) {
+      Ptr = mScanner.skipWord(Ptr + 1, End) - 1;
+      std::string_view Word(WordBegin, Ptr + 1 - WordBegin);
+      if (auto Kind = Keyword::getWordKind(Word)) {
+        if (Keyword::isForbiddenKeyword(*Kind))
+          throw ParserException("Forbidden keyword at " + getErrorPos(Ptr));
+        Keyword::addDynamicKeyword(*Kind, TokenList, getPos(WordBegin));
       } else if (Boolean::isBoolean(Word)) {
         TokenList.push_back(std::make_unique<Boolean>(Word, getPos(WordBegin)));
       } else {
@@ -77,38 +92,24 @@ void LexicalAnalyzer::parseLine(const std::string &Line) {
     } else if (Peek == '#') {
       return;
     } else if (Peek == '\"') {
-      std::string Word = "";
-      ++Itr;
-      while (Itr != Buffer.cend() && *Itr != '\"') {
-        Word += *Itr;
-        ++Itr;
-      }
-      if (Itr == Buffer.cend())
-        throw ParserException("Incomplete literal at " + getErrorPos(Itr));
-      TokenList.push_back(std::make_unique<String>(Word, getPos(WordBegin)));
+      ++Ptr;
+      auto *Quote = mScanner.find(Ptr, End, '\"');
+      if (Quote == End)
+        throw ParserException("Incomplete literal at " + getErrorPos(End));
+      TokenList.push_back(std::make_unique<String>(
+          std::string_view(Ptr, Quote - Ptr), getPos(WordBegin)));
+      Ptr = Quote;
     } else if (Keyword::isPunctChar(Peek)) {
-      std::string Word { Peek };
-      auto SubItr = Itr;
-      auto Next = Buffer.lookAhead(SubItr);
-      while (Next && Keyword::isPunctChar(*Next)) {
-        Word += *Next;
-        ++SubItr;
-        Next = Buffer.lookAhead(SubItr);
-      }
-      std::size_t Len = Word.length();
-      //DRAGON_DEBUG(dbgs() << "PunctWord: " << Word << "\n");
-      while (Len > 0 && !Keyword::isKeyword(Word.substr(0, Len)))
-        --Len;
-      assert(Len > 0 && "Punctuation character must have a keyword!");
-      Keyword::addDynamicKeyword(Word.substr(0, Len), TokenList,
-                                 getPos(WordBegin));
-      --Len;
-      while (Len) {
-        ++Itr;
-        --Len;
-      }
+      Keyword::Kind Kind;
+      auto Len = Keyword::matchOperator(std::string_view(Ptr, End - Ptr),
+                                        Kind);
+      if (!Len)
+        throw ParserException("Invalid characher at " + getErrorPos(Ptr) +
+                              ": " + Peek);
+      Keyword::addDynamicKeyword(Kind, TokenList, getPos(WordBegin));
+      Ptr += Len - 1;
     } else {
-      throw ParserException("Invalid characher at " + getErrorPos(Itr) +
+      throw ParserException("Invalid characher at " + getErrorPos(Ptr) +
                             ": " + Peek);
     }
   }
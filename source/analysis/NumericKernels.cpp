@@ -0,0 +1,512 @@
+#include "dragon/analysis/NumericKernels.h"
+#include "dragon/Common.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+ #define DRAGON_NUMERIC_X86
+ #include <immintrin.h>
+#endif
+
+namespace {
+
+/* Scalar kernels, also used for the tails of the vector ones */
+
+void fillScalar(std::uint64_t *Data, std::size_t N, std::uint64_t Bits) {
+  std::fill_n(Data, N, Bits);
+}
+
+double sumScalar(const double *X, std::size_t N) {
+  double Sum = 0;
+  for (std::size_t I = 0; I < N; ++I)
+    Sum += X[I];
+  return Sum;
+}
+
+bool sumIntScalar(const std::int64_t *X, std::size_t N, std::int64_t &Res) {
+  std::int64_t Sum = 0;
+  for (std::size_t I = 0; I < N; ++I)
+    if (__builtin_add_overflow(Sum, X[I], &Sum))
+      return false;
+  Res = Sum;
+  return true;
+}
+
+template <typename T> T minScalar(const T *X, std::size_t N) {
+  T Min = X[0];
+  for (std::size_t I = 1; I < N; ++I)
+    Min = X[I] < Min ? X[I] : Min;
+  return Min;
+}
+
+template <typename T> T maxScalar(const T *X, std::size_t N) {
+  T Max = X[0];
+  for (std::size_t I = 1; I < N; ++I)
+    Max = X[I] > Max ? X[I] : Max;
+  return Max;
+}
+
+double dotScalar(const double *X, const double *Y, std::size_t N) {
+  double Sum = 0;
+  for (std::size_t I = 0; I < N; ++I)
+    Sum += X[I] * Y[I];
+  return Sum;
+}
+
+void axpyScalar(double A, const double *X, double *Y, std::size_t N) {
+  for (std::size_t I = 0; I < N; ++I)
+    Y[I] += A * X[I];
+}
+
+void addScalar(const double *X, const double *Y, double *Out,
+               std::size_t N) {
+  for (std::size_t I = 0; I < N; ++I)
+    Out[I] = X[I] + Y[I];
+}
+
+bool addIntScalar(const std::int64_t *X, const std::int64_t *Y,
+                  std::int64_t *Out, std::size_t N) {
+  for (std::size_t I = 0; I < N; ++I)
+    if (__builtin_add_overflow(X[I], Y[I], &Out[I]))
+      return false;
+  return true;
+}
+
+void mulScalar(const double *X, const double *Y, double *Out,
+               std::size_t N) {
+  for (std::size_t I = 0; I < N; ++I)
+    Out[I] = X[I] * Y[I];
+}
+
+void prefixSumScalar(const double *X, double *Out, std::size_t N) {
+  double Sum = 0;
+  for (std::size_t I = 0; I < N; ++I)
+    Out[I] = Sum += X[I];
+}
+
+#ifdef DRAGON_NUMERIC_X86
+
+/* SSE2 kernels on two lanes */
+
+// Sign bits of the lanes whose signed addition X + Y = Sum overflowed.
+inline __m128i overflow128(__m128i X, __m128i Y, __m128i Sum) {
+  return _mm_and_si128(_mm_xor_si128(X, Sum), _mm_xor_si128(Y, Sum));
+}
+
+inline bool anySign128(__m128i X) {
+  return _mm_movemask_pd(_mm_castsi128_pd(X)) != 0;
+}
+
+inline double horizontalSum128(__m128d X) {
+  return _mm_cvtsd_f64(_mm_add_sd(X, _mm_unpackhi_pd(X, X)));
+}
+
+void fillSSE2(std::uint64_t *Data, std::size_t N, std::uint64_t Bits) {
+  auto V = _mm_set1_epi64x(Bits);
+  std::size_t I = 0;
+  for (; I + 2 <= N; I += 2)
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(Data + I), V);
+  fillScalar(Data + I, N - I, Bits);
+}
+
+// Two accumulators hide the latency of the additions.
+double sumSSE2(const double *X, std::size_t N) {
+  auto Acc0 = _mm_setzero_pd(), Acc1 = _mm_setzero_pd();
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4) {
+    Acc0 = _mm_add_pd(Acc0, _mm_loadu_pd(X + I));
+    Acc1 = _mm_add_pd(Acc1, _mm_loadu_pd(X + I + 2));
+  }
+  return horizontalSum128(_mm_add_pd(Acc0, Acc1)) + sumScalar(X + I, N - I);
+}
+
+// A lane that overflows makes the whole sum fail, even if the other lane
+// would have brought it back into range; the caller then sums exactly.
+bool sumIntSSE2(const std::int64_t *X, std::size_t N, std::int64_t &Res) {
+  auto Acc = _mm_setzero_si128(), Overflow = _mm_setzero_si128();
+  std::size_t I = 0;
+  for (; I + 2 <= N; I += 2) {
+    auto V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(X + I));
+    auto Sum = _mm_add_epi64(Acc, V);
+    Overflow = _mm_or_si128(Overflow, overflow128(Acc, V, Sum));
+    Acc = Sum;
+  }
+  if (anySign128(Overflow))
+    return false;
+  alignas(16) std::int64_t Lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(Lanes), Acc);
+  std::int64_t Tail;
+  return sumIntScalar(X + I, N - I, Tail) &&
+         !__builtin_add_overflow(Lanes[0], Lanes[1], &Res) &&
+         !__builtin_add_overflow(Res, Tail, &Res);
+}
+
+#define DRAGON_SSE2_REDUCE(Name, Op, Scalar)                                  \
+  double Name(const double *X, std::size_t N) {                              \
+    if (N < 2)                                                               \
+      return Scalar(X, N);                                                   \
+    auto Acc = _mm_loadu_pd(X);                                              \
+    std::size_t I = 2;                                                       \
+    for (; I + 2 <= N; I += 2)                                               \
+      Acc = Op(_mm_loadu_pd(X + I), Acc);                                    \
+    alignas(16) double Lanes[3];                                             \
+    _mm_store_pd(Lanes, Acc);                                                \
+    Lanes[2] = I < N ? X[I] : Lanes[0];                                      \
+    return Scalar(Lanes, 3);                                                 \
+  }
+
+DRAGON_SSE2_REDUCE(minSSE2, _mm_min_pd, minScalar<double>)
+DRAGON_SSE2_REDUCE(maxSSE2, _mm_max_pd, maxScalar<double>)
+
+#undef DRAGON_SSE2_REDUCE
+
+double dotSSE2(const double *X, const double *Y, std::size_t N) {
+  auto Acc0 = _mm_setzero_pd(), Acc1 = _mm_setzero_pd();
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4) {
+    Acc0 = _mm_add_pd(Acc0, _mm_mul_pd(_mm_loadu_pd(X + I),
+                                       _mm_loadu_pd(Y + I)));
+    Acc1 = _mm_add_pd(Acc1, _mm_mul_pd(_mm_loadu_pd(X + I + 2),
+                                       _mm_loadu_pd(Y + I + 2)));
+  }
+  return horizontalSum128(_mm_add_pd(Acc0, Acc1)) +
+         dotScalar(X + I, Y + I, N - I);
+}
+
+void axpySSE2(double A, const double *X, double *Y, std::size_t N) {
+  auto VA = _mm_set1_pd(A);
+  std::size_t I = 0;
+  for (; I + 2 <= N; I += 2)
+    _mm_storeu_pd(Y + I, _mm_add_pd(_mm_loadu_pd(Y + I),
+                                    _mm_mul_pd(VA, _mm_loadu_pd(X + I))));
+  axpyScalar(A, X + I, Y + I, N - I);
+}
+
+#define DRAGON_SSE2_BINARY(Name, Op, Scalar)                                  \
+  void Name(const double *X, const double *Y, double *Out, std::size_t N) {  \
+    std::size_t I = 0;                                                       \
+    for (; I + 2 <= N; I += 2)                                               \
+      _mm_storeu_pd(Out + I, Op(_mm_loadu_pd(X + I), _mm_loadu_pd(Y + I)));  \
+    Scalar(X + I, Y + I, Out + I, N - I);                                    \
+  }
+
+DRAGON_SSE2_BINARY(addSSE2, _mm_add_pd, addScalar)
+DRAGON_SSE2_BINARY(mulSSE2, _mm_mul_pd, mulScalar)
+
+#undef DRAGON_SSE2_BINARY
+
+bool addIntSSE2(const std::int64_t *X, const std::int64_t *Y,
+                std::int64_t *Out, std::size_t N) {
+  auto Overflow = _mm_setzero_si128();
+  std::size_t I = 0;
+  for (; I + 2 <= N; I += 2) {
+    auto VX = _mm_loadu_si128(reinterpret_cast<const __m128i *>(X + I));
+    auto VY = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Y + I));
+    auto Sum = _mm_add_epi64(VX, VY);
+    Overflow = _mm_or_si128(Overflow, overflow128(VX, VY, Sum));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(Out + I), Sum);
+  }
+  return !anySign128(Overflow) && addIntScalar(X + I, Y + I, Out + I, N - I);
+}
+
+// [a, b] becomes [a, a + b], then the sum of everything before is added.
+void prefixSumSSE2(const double *X, double *Out, std::size_t N) {
+  auto Carry = _mm_setzero_pd();
+  std::size_t I = 0;
+  for (; I + 2 <= N; I += 2) {
+    auto V = _mm_loadu_pd(X + I);
+    V = _mm_add_pd(V, _mm_unpacklo_pd(_mm_setzero_pd(), V));
+    V = _mm_add_pd(V, Carry);
+    _mm_storeu_pd(Out + I, V);
+    Carry = _mm_unpackhi_pd(V, V);
+  }
+  if (I < N)
+    Out[I] = _mm_cvtsd_f64(Carry) + X[I];
+}
+
+/* AVX2 kernels, same as above on four lanes */
+
+#define DRAGON_AVX2 __attribute__((target("avx2")))
+
+DRAGON_AVX2 inline __m256i overflow256(__m256i X, __m256i Y, __m256i Sum) {
+  return _mm256_and_si256(_mm256_xor_si256(X, Sum),
+                          _mm256_xor_si256(Y, Sum));
+}
+
+DRAGON_AVX2 inline bool anySign256(__m256i X) {
+  return _mm256_movemask_pd(_mm256_castsi256_pd(X)) != 0;
+}
+
+DRAGON_AVX2 inline double horizontalSum256(__m256d X) {
+  return horizontalSum128(_mm_add_pd(_mm256_castpd256_pd128(X),
+                                     _mm256_extractf128_pd(X, 1)));
+}
+
+DRAGON_AVX2 void fillAVX2(std::uint64_t *Data, std::size_t N,
+                          std::uint64_t Bits) {
+  auto V = _mm256_set1_epi64x(Bits);
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4)
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(Data + I), V);
+  fillSSE2(Data + I, N - I, Bits);
+}
+
+DRAGON_AVX2 double sumAVX2(const double *X, std::size_t N) {
+  auto Acc0 = _mm256_setzero_pd(), Acc1 = _mm256_setzero_pd();
+  std::size_t I = 0;
+  for (; I + 8 <= N; I += 8) {
+    Acc0 = _mm256_add_pd(Acc0, _mm256_loadu_pd(X + I));
+    Acc1 = _mm256_add_pd(Acc1, _mm256_loadu_pd(X + I + 4));
+  }
+  return horizontalSum256(_mm256_add_pd(Acc0, Acc1)) +
+         sumScalar(X + I, N - I);
+}
+
+DRAGON_AVX2 bool sumIntAVX2(const std::int64_t *X, std::size_t N,
+                            std::int64_t &Res) {
+  auto Acc = _mm256_setzero_si256(), Overflow = _mm256_setzero_si256();
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4) {
+    auto V = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(X + I));
+    auto Sum = _mm256_add_epi64(Acc, V);
+    Overflow = _mm256_or_si256(Overflow, overflow256(Acc, V, Sum));
+    Acc = Sum;
+  }
+  if (anySign256(Overflow))
+    return false;
+  alignas(32) std::int64_t Lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(Lanes), Acc);
+  std::int64_t Tail;
+  return sumIntScalar(Lanes, 4, Res) && sumIntScalar(X + I, N - I, Tail) &&
+         !__builtin_add_overflow(Res, Tail, &Res);
+}
+
+#define DRAGON_AVX2_REDUCE(Name, Op, Scalar)                                  \
+  DRAGON_AVX2 double Name(const double *X, std::size_t N) {                  \
+    if (N < 4)                                                               \
+      return Scalar(X, N);                                                   \
+    auto Acc = _mm256_loadu_pd(X);                                           \
+    std::size_t I = 4;                                                       \
+    for (; I + 4 <= N; I += 4)                                               \
+      Acc = Op(_mm256_loadu_pd(X + I), Acc);                                 \
+    alignas(32) double Lanes[7];                                             \
+    _mm256_store_pd(Lanes, Acc);                                             \
+    std::copy(X + I, X + N, Lanes + 4);                                      \
+    return Scalar(Lanes, 4 + N - I);                                         \
+  }
+
+DRAGON_AVX2_REDUCE(minAVX2, _mm256_min_pd, minScalar<double>)
+DRAGON_AVX2_REDUCE(maxAVX2, _mm256_max_pd, maxScalar<double>)
+
+#undef DRAGON_AVX2_REDUCE
+
+// AVX2 has only a greater-than compare for 64-bit ints.
+#define DRAGON_AVX2_REDUCE_INT(Name, IsBetter, Scalar)                        \
+  DRAGON_AVX2 std::int64_t Name(const std::int64_t *X, std::size_t N) {      \
+    if (N < 4)                                                               \
+      return Scalar(X, N);                                                   \
+    auto Acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(X));     \
+    std::size_t I = 4;                                                       \
+    for (; I + 4 <= N; I += 4) {                                             \
+      auto V = _mm256_loadu_si256(                                           \
+          reinterpret_cast<const __m256i *>(X + I));                         \
+      Acc = _mm256_blendv_epi8(Acc, V, IsBetter(V, Acc));                    \
+    }                                                                        \
+    alignas(32) std::int64_t Lanes[7];                                       \
+    _mm256_store_si256(reinterpret_cast<__m256i *>(Lanes), Acc);             \
+    std::copy(X + I, X + N, Lanes + 4);                                      \
+    return Scalar(Lanes, 4 + N - I);                                         \
+  }
+
+#define DRAGON_LESS(V, Acc) _mm256_cmpgt_epi64(Acc, V)
+#define DRAGON_GREATER(V, Acc) _mm256_cmpgt_epi64(V, Acc)
+DRAGON_AVX2_REDUCE_INT(minIntAVX2, DRAGON_LESS, minScalar<std::int64_t>)
+DRAGON_AVX2_REDUCE_INT(maxIntAVX2, DRAGON_GREATER, maxScalar<std::int64_t>)
+#undef DRAGON_GREATER
+#undef DRAGON_LESS
+
+#undef DRAGON_AVX2_REDUCE_INT
+
+DRAGON_AVX2 double dotAVX2(const double *X, const double *Y, std::size_t N) {
+  auto Acc0 = _mm256_setzero_pd(), Acc1 = _mm256_setzero_pd();
+  std::size_t I = 0;
+  for (; I + 8 <= N; I += 8) {
+    Acc0 = _mm256_add_pd(Acc0, _mm256_mul_pd(_mm256_loadu_pd(X + I),
+                                             _mm256_loadu_pd(Y + I)));
+    Acc1 = _mm256_add_pd(Acc1, _mm256_mul_pd(_mm256_loadu_pd(X + I + 4),
+                                             _mm256_loadu_pd(Y + I + 4)));
+  }
+  return horizontalSum256(_mm256_add_pd(Acc0, Acc1)) +
+         dotScalar(X + I, Y + I, N - I);
+}
+
+// Multiplication and addition stay separate, as in the other levels: a
+// fused multiply-add would round differently.
+DRAGON_AVX2 void axpyAVX2(double A, const double *X, double *Y,
+                          std::size_t N) {
+  auto VA = _mm256_set1_pd(A);
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4)
+    _mm256_storeu_pd(Y + I, _mm256_add_pd(_mm256_loadu_pd(Y + I),
+        _mm256_mul_pd(VA, _mm256_loadu_pd(X + I))));
+  axpyScalar(A, X + I, Y + I, N - I);
+}
+
+#define DRAGON_AVX2_BINARY(Name, Op, Scalar)                                  \
+  DRAGON_AVX2 void Name(const double *X, const double *Y, double *Out,       \
+                        std::size_t N) {                                     \
+    std::size_t I = 0;                                                       \
+    for (; I + 4 <= N; I += 4)                                               \
+      _mm256_storeu_pd(Out + I, Op(_mm256_loadu_pd(X + I),                   \
+                                   _mm256_loadu_pd(Y + I)));                 \
+    Scalar(X + I, Y + I, Out + I, N - I);                                    \
+  }
+
+DRAGON_AVX2_BINARY(addAVX2, _mm256_add_pd, addScalar)
+DRAGON_AVX2_BINARY(mulAVX2, _mm256_mul_pd, mulScalar)
+
+#undef DRAGON_AVX2_BINARY
+
+DRAGON_AVX2 bool addIntAVX2(const std::int64_t *X, const std::int64_t *Y,
+                            std::int64_t *Out, std::size_t N) {
+  auto Overflow = _mm256_setzero_si256();
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4) {
+    auto VX = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(X + I));
+    auto VY = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Y + I));
+    auto Sum = _mm256_add_epi64(VX, VY);
+    Overflow = _mm256_or_si256(Overflow, overflow256(VX, VY, Sum));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(Out + I), Sum);
+  }
+  return !anySign256(Overflow) && addIntScalar(X + I, Y + I, Out + I, N - I);
+}
+
+// [a, b, c, d] is scanned in two steps of shifting by one and two lanes,
+// then the sum of everything before is added.
+DRAGON_AVX2 void prefixSumAVX2(const double *X, double *Out, std::size_t N) {
+  auto Zero = _mm256_setzero_pd();
+  auto Carry = Zero;
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4) {
+    auto V = _mm256_loadu_pd(X + I);
+    V = _mm256_add_pd(V, _mm256_blend_pd(
+        _mm256_permute4x64_pd(V, _MM_SHUFFLE(2, 1, 0, 0)), Zero, 0x1));
+    V = _mm256_add_pd(V, _mm256_blend_pd(
+        _mm256_permute4x64_pd(V, _MM_SHUFFLE(1, 0, 0, 0)), Zero, 0x3));
+    V = _mm256_add_pd(V, Carry);
+    _mm256_storeu_pd(Out + I, V);
+    Carry = _mm256_permute4x64_pd(V, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  double Sum = _mm256_cvtsd_f64(Carry);
+  for (; I < N; ++I)
+    Out[I] = Sum += X[I];
+}
+
+#undef DRAGON_AVX2
+
+#endif
+
+} // namespace
+
+NumericKernels::NumericKernels(ScanLevel Level) : mLevel(Level) {
+  assert(CharScanner::isSupported(Level) &&
+         "Vector level is not supported by the CPU!");
+  mFill = fillScalar;
+  mSum = sumScalar;
+  mSumInt = sumIntScalar;
+  mMin = minScalar<double>;
+  mMax = maxScalar<double>;
+  mMinInt = minScalar<std::int64_t>;
+  mMaxInt = maxScalar<std::int64_t>;
+  mDot = dotScalar;
+  mAxpy = axpyScalar;
+  mAdd = addScalar;
+  mAddInt = addIntScalar;
+  mMul = mulScalar;
+  mPrefixSum = prefixSumScalar;
+  switch (Level) {
+  case ScanLevel::SCALAR:
+    break;
+#ifdef DRAGON_NUMERIC_X86
+  case ScanLevel::SSE2:
+    mFill = fillSSE2;
+    mSum = sumSSE2;
+    mSumInt = sumIntSSE2;
+    mMin = minSSE2;
+    mMax = maxSSE2;
+    mDot = dotSSE2;
+    mAxpy = axpySSE2;
+    mAdd = addSSE2;
+    mAddInt = addIntSSE2;
+    mMul = mulSSE2;
+    mPrefixSum = prefixSumSSE2;
+    break;
+  case ScanLevel::AVX2:
+    mFill = fillAVX2;
+    mSum = sumAVX2;
+    mSumInt = sumIntAVX2;
+    mMin = minAVX2;
+    mMax = maxAVX2;
+    mMinInt = minIntAVX2;
+    mMaxInt = maxIntAVX2;
+    mDot = dotAVX2;
+    mAxpy = axpyAVX2;
+    mAdd = addAVX2;
+    mAddInt = addIntAVX2;
+    mMul = mulAVX2;
+    mPrefixSum = prefixSumAVX2;
+    break;
+#else
+  default:
+    mLevel = ScanLevel::SCALAR;
+    break;
+#endif
+  }
+}
+
+bool NumericKernels::dot(const std::int64_t *X, const std::int64_t *Y,
+                         std::size_t N, std::int64_t &Res) const {
+  std::int64_t Sum = 0, Product;
+  for (std::size_t I = 0; I < N; ++I)
+    if (__builtin_mul_overflow(X[I], Y[I], &Product) ||
+        __builtin_add_overflow(Sum, Product, &Sum))
+      return false;
+  Res = Sum;
+  return true;
+}
+
+bool NumericKernels::axpy(std::int64_t A, const std::int64_t *X,
+                          std::int64_t *Y, std::size_t N) const {
+  std::int64_t Product;
+  for (std::size_t I = 0; I < N; ++I)
+    if (__builtin_mul_overflow(A, X[I], &Product) ||
+        __builtin_add_overflow(Y[I], Product, &Y[I]))
+      return false;
+  return true;
+}
+
+bool NumericKernels::mul(const std::int64_t *X, const std::int64_t *Y,
+                         std::int64_t *Out, std::size_t N) const {
+  for (std::size_t I = 0; I < N; ++I)
+    if (__builtin_mul_overflow(X[I], Y[I], &Out[I]))
+      return false;
+  return true;
+}
+
+bool NumericKernels::prefixSum(const std::int64_t *X, std::int64_t *Out,
+                               std::size_t N) const {
+  std::int64_t Sum = 0;
+  for (std::size_t I = 0; I < N; ++I)
+    if (__builtin_add_overflow(Sum, X[I], &Sum))
+      return false;
+    else
+      Out[I] = Sum;
+  return true;
+}
+
+ScanLevel NumericKernels::getBestLevel() {
+  static const ScanLevel Best =
+      CharScanner::isSupported(ScanLevel::AVX2) ? ScanLevel::AVX2 :
+      CharScanner::isSupported(ScanLevel::SSE2) ? ScanLevel::SSE2 :
+                                                  ScanLevel::SCALAR;
+  return Best;
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "dragon/analysis/Operations.h"
+#include "dragon/analysis/Dict.h"
+#include <limits>
+
+namespace {
+bool isInteger(const Value &Val) { return Val.isInt() || Val.isBigInt(); }
+
+BigInt toBigInt(const Value &Val) {
+  return Val.isInt() ? BigInt(Val.getInt()) : Val.getBigInt();
+}
+
+double toDouble(const Value &Val) {
+  return Val.isBigInt() ? Val.getBigInt().toDouble() : Val.getNumber();
+}
+
+// Integer operators once an operand or the result leaves the 64-bit range.
+Value processBigInt(Opcode Op, const BigInt &Left, const BigInt &Right,
+                    const PosInfo &PI, Arena &Strings) {
+  switch (Op) {
+  case Opcode::EQ: return Value(Left.compare(Right) == 0);
+  case Opcode::NE: return Value(Left.compare(Right) != 0);
+  case Opcode::LT: return Value(Left.compare(Right) < 0);
+  case Opcode::LE: return Value(Left.compare(Right) <= 0);
+  case Opcode::GT: return Value(Left.compare(Right) > 0);
+  case Opcode::GE: return Value(Left.compare(Right) >= 0);
+  case Opcode::DIV: return Value(Left.toDouble() / Right.toDouble());
+  case Opcode::ADD: return makeInteger(Left + Right, Strings);
+  case Opcode::SUB: return makeInteger(Left - Right, Strings);
+  case Opcode::MUL: return makeInteger(Left * Right, Strings);
+  case Opcode::BIT_AND: return makeInteger(Left & Right, Strings);
+  case Opcode::BIT_OR: return makeInteger(Left | Right, Strings);
+  case Opcode::BIT_XOR: return makeInteger(Left ^ Right, Strings);
+  case Opcode::MOD:
+    if (Right.isZero())
+      throw InterpreterException("Division by zero at " +
+                                 Token::posToString(PI));
+    return makeInteger(Left % Right, Strings);
+  case Opcode::SHL:
+  case Opcode::SHR: {
+    auto Count = Right.toInt64();
+    if (Right.isNegative())
+      throw InterpreterException("Negative shift count at " +
+                                 Token::posToString(PI));
+    if (Op == Opcode::SHR) {
+      if (!Count)
+        return Value(Left.isNegative() ? -1 : 0);
+      return makeInteger(Left.shr(*Count), Strings);
+    }
+    // The flat form of the result must fit in a string object.
+    if (!Count || *Count > std::numeric_limits<std::uint32_t>::max())
+      throw InterpreterException("Shift count is too large at " +
+                                 Token::posToString(PI));
+    return makeInteger(Left.shl(*Count), Strings);
+  }
+  default:
+    break;
+  }
+  assert(0 && "Unexpected integer operation!");
+  return Value();
+}
+} // namespace
+
+Value makeInteger(const BigInt &Int, Arena &Strings) {
+  if (auto Small = Int.toInt64())
+    return Value(*Small);
+  auto Size = Int.getByteSize();
+  if (Size > std::numeric_limits<std::uint32_t>::max())
+    throw InterpreterException("Integer is too large");
+  auto Obj = StringObject::create(
+      Strings.allocate(StringObject::getAllocSize(Size)), Size);
+  Int.writeBytes(Obj->getData());
+  return Value::makeBigInt(Obj);
+}
+
+Value processUnary(Opcode Op, const Value &Top, const PosInfo &PI,
+                   Arena &Strings) {
+  DRAGON_DEBUG(dbgs() << "[RUNTIME] Processing unary operator `" <<
+               opcodeToString(Op) << "` for value " << Top.toString() <<
+               ".\n");
+  if (Op == Opcode::POS) {
+    if (isInteger(Top) || Top.isFloat())
+      return Top;
+  } else if (Op == Opcode::NEG) {
+    if (Top.isInt() && Top.getInt() != std::numeric_limits<std::int64_t>::min())
+      return Value(-Top.getInt());
+    if (isInteger(Top))
+      return makeInteger(-toBigInt(Top), Strings);
+    if (Top.isFloat())
+      return Value(-Top.getFloat());
+  } else if (Op == Opcode::NOT) {
+    if (Top.isBool())
+      return Value(!Top.getBool());
+  } else if (Op == Opcode::LEN) {
+    if (Top.isString())
+      return Value(Top.getString().size());
+    if (Top.isArray())
+      return Value(Top.getArrayLength());
+    if (Top.isDict())
+      return Value(Top.getDict().size());
+  }
+  throw InterpreterException("Unexpected operand type for unary operator " +
+                             Token::posToString(PI));
+}
+
+Value processBinary(Opcode Op, const Value &OpLeft, const Value &OpRight,
+                    const PosInfo &PI, Arena &Strings) {
+  DRAGON_DEBUG(dbgs() << "[RUNTIME] Processing binary operation `" <<
+               opcodeToString(Op) << "` for values: " <<
+               OpLeft.toString() << ", " << OpRight.toString() << ".\n");
+  switch (Op) {
+  case Opcode::AND:
+  case Opcode::OR:
+    if (!OpLeft.isBool() || !OpRight.isBool())
+      throw InterpreterException("Type mismatch for logical operation at " +
+                                 Token::posToString(PI));
+    return Value(Op == Opcode::OR ?
+        (OpLeft.getBool() || OpRight.getBool()) :
+        (OpLeft.getBool() && OpRight.getBool()));
+  case Opcode::IN:
+    // A dict on the right is handled by the interpreter.
+    throw InterpreterException("Dict expected for `in` at " +
+                               Token::posToString(PI));
+  case Opcode::BIT_AND:
+  case Opcode::BIT_OR:
+  case Opcode::BIT_XOR:
+  case Opcode::SHL:
+  case Opcode::SHR:
+  case Opcode::MOD: {
+    if (!isInteger(OpLeft) || !isInteger(OpRight))
+      throw InterpreterException("Type mismatch for bitwise operation at " +
+                                 Token::posToString(PI));
+    Value Res;
+    if (OpLeft.isInt() && OpRight.isInt() &&
+        processInteger(Op, OpLeft.getInt(), OpRight.getInt(), Res))
+      return Res;
+    return processBigInt(Op, toBigInt(OpLeft), toBigInt(OpRight), PI,
+                         Strings);
+  }
+  default:
+    if (isInteger(OpLeft) && isInteger(OpRight)) {
+      Value Res;
+      if (OpLeft.isInt() && OpRight.isInt() &&
+          processInteger(Op, OpLeft.getInt(), OpRight.getInt(), Res))
+        return Res;
+      return processBigInt(Op, toBigInt(OpLeft), toBigInt(OpRight), PI,
+                           Strings);
+    }
+    if ((OpLeft.isNumber() || OpLeft.isBigInt()) &&
+        (OpRight.isNumber() || OpRight.isBigInt()))
+      return processArithmetic(Op, toDouble(OpLeft), toDouble(OpRight));
+    if (OpLeft.isString() && OpRight.isString()) {
+      if (Op == Opcode::EQ)
+        return Value(OpLeft.getString() == OpRight.getString());
+      else if (Op == Opcode::NE)
+        return Value(OpLeft.getString() != OpRight.getString());
+      else if (Op == Opcode::ADD)
+        return concat(OpLeft.getString(), OpRight.getString(), Strings);
+      else
+        throw InterpreterException("It is forbidden to compare strings");
+    }
+    if (OpLeft.isBool() && OpRight.isBool()) {
+      if (Op == Opcode::EQ)
+        return Value(OpLeft.getBool() == OpRight.getBool());
+      else if (Op == Opcode::NE)
+        return Value(OpLeft.getBool() != OpRight.getBool());
+      else
+        throw InterpreterException("It is forbidden to compare bools");
+    }
+    throw InterpreterException("Type mismatch for binary operation at " +
+        Token::posToString(PI));
+  }
+}
+
+Value concat(std::string_view Left, std::string_view Right, Arena &Strings) {
+  auto Length = Left.size() + Right.size();
+  if (Length <= Value::MaxInlineLength) {
+    char Buf[Value::MaxInlineLength];
+    std::copy(Left.begin(), Left.end(), Buf);
+    std::copy(Right.begin(), Right.end(), Buf + Left.size());
+    return Value::makeInline(std::string_view(Buf, Length));
+  }
+  auto Str = StringObject::create(
+      Strings.allocate(StringObject::getAllocSize(Length)), Length);
+  std::copy(Left.begin(), Left.end(), Str->getData());
+  std::copy(Right.begin(), Right.end(), Str->getData() + Left.size());
+  return Value(Str);
+}
\ No newline at end of file
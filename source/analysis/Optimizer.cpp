@@ -0,0 +1,226 @@
+#include "dragon/analysis/Optimizer.h"
+#include "dragon/analysis/Operations.h"
+
+namespace {
+bool isJump(Opcode Op) {
+  return Op == Opcode::JMP || Op == Opcode::JMP_IF ||
+         Op == Opcode::JMP_IF_FALSE || Op == Opcode::FOR_NEXT;
+}
+
+bool isBinary(Opcode Op) {
+  return Op >= Opcode::ADD && Op <= Opcode::GE;
+}
+
+bool isComparison(Opcode Op) {
+  return Op >= Opcode::EQ && Op <= Opcode::GE;
+}
+
+bool isConditionalJump(Opcode Op) {
+  return Op == Opcode::JMP_IF || Op == Opcode::JMP_IF_FALSE;
+}
+
+// Binary operators the fused instructions evaluate on numbers themselves.
+bool hasFastPath(Opcode Op) {
+  return isBinary(Op) && Op != Opcode::AND && Op != Opcode::OR;
+}
+} // namespace
+
+bool Optimizer::foldUnary() {
+  auto &Operand = mOut[mOut.size() - 2];
+  auto &Op = mOut.back();
+  if (Operand.I.Op != Opcode::PUSH_CONST ||
+      (Op.I.Op != Opcode::POS && Op.I.Op != Opcode::NEG &&
+       Op.I.Op != Opcode::NOT && Op.I.Op != Opcode::LEN))
+    return false;
+  auto Mark = mStrings.mark();
+  Value Res;
+  try {
+    Res = processUnary(Op.I.Op, mCF.getConstant(Operand.I.A), Op.PI,
+                       mStrings);
+  } catch (InterpreterException &) {
+    // Leave the error to the runtime, the code may never be executed.
+    return false;
+  }
+  // Constants never hold big integers.
+  if (Res.isBigInt()) {
+    mStrings.release(Mark);
+    return false;
+  }
+  Operand.I.A = mCF.addConstant(Res);
+  Operand.PI = Op.PI;
+  mOut.pop_back();
+  return true;
+}
+
+bool Optimizer::foldBinary() {
+  if (mOut.size() < 3 || !isBinary(mOut.back().I.Op))
+    return false;
+  auto &Left = mOut[mOut.size() - 3];
+  auto &Right = mOut[mOut.size() - 2];
+  auto &Op = mOut.back();
+  if (Left.I.Op != Opcode::PUSH_CONST || Right.I.Op != Opcode::PUSH_CONST ||
+      Right.IsTarget)
+    return false;
+  auto Mark = mStrings.mark();
+  Value Res;
+  try {
+    Res = processBinary(Op.I.Op, mCF.getConstant(Left.I.A),
+                        mCF.getConstant(Right.I.A), Op.PI, mStrings);
+  } catch (InterpreterException &) {
+    return false;
+  }
+  if (Res.isBigInt()) {
+    mStrings.release(Mark);
+    return false;
+  }
+  Left.I.A = mCF.addConstant(Res);
+  Left.PI = Op.PI;
+  mOut.resize(mOut.size() - 2);
+  mStrings.release(Mark);
+  return true;
+}
+
+bool Optimizer::foldBranch() {
+  auto &Cond = mOut[mOut.size() - 2];
+  auto &Jump = mOut.back();
+  if (Jump.I.Op != Opcode::JMP_IF && Jump.I.Op != Opcode::JMP_IF_FALSE)
+    return false;
+  if (Jump.I.Op == Opcode::JMP_IF && Cond.I.Op == Opcode::NOT) {
+    Cond.I = { Opcode::JMP_IF_FALSE, Jump.I.A, 0 };
+    mOut.pop_back();
+    return true;
+  }
+  if (Cond.I.Op != Opcode::PUSH_CONST || !mCF.getConstant(Cond.I.A).isBool())
+    return false;
+  if (mCF.getConstant(Cond.I.A).getBool() == (Jump.I.Op == Opcode::JMP_IF)) {
+    Cond.I = { Opcode::JMP, Jump.I.A, 0 };
+    Cond.PI = Jump.PI;
+    mOut.pop_back();
+  } else {
+    mOut.resize(mOut.size() - 2);
+  }
+  return true;
+}
+
+bool Optimizer::reduceTail() {
+  if (mOut.size() < 2 || mOut.back().IsTarget)
+    return false;
+  return foldUnary() || foldBinary() || foldBranch();
+}
+
+std::vector<bool> Optimizer::findTargets() const {
+  auto &Code = mCF.getCode();
+  std::vector<bool> IsTarget(Code.size() + 1);
+  for (auto &I : Code)
+    if (isJump(I.Op))
+      IsTarget[I.A] = true;
+  return IsTarget;
+}
+
+void Optimizer::replaceCode(const std::vector<std::size_t> &NewPC) {
+  CompiledFunction::CodeList NewCode;
+  std::vector<PosInfo> Positions;
+  NewCode.reserve(mOut.size());
+  Positions.reserve(mOut.size());
+  for (auto &E : mOut) {
+    if (isJump(E.I.Op))
+      E.I.A = NewPC[E.I.A];
+    NewCode.push_back(E.I);
+    Positions.push_back(E.PI);
+  }
+  mOut.clear();
+  mCF.setCode(std::move(NewCode), std::move(Positions));
+}
+
+void Optimizer::foldConstants() {
+  auto &Code = mCF.getCode();
+  auto IsTarget = findTargets();
+  // New offset of every instruction. An instruction removed by a reduction
+  // maps to whatever is emitted in its place, which is what a jump to it
+  // has to execute next.
+  std::vector<std::size_t> NewPC(Code.size() + 1);
+  for (std::size_t PC = 0; PC < Code.size(); ++PC) {
+    NewPC[PC] = mOut.size();
+    mOut.push_back({ Code[PC], mCF.getPosInfo(PC), IsTarget[PC] });
+    while (reduceTail())
+      ;
+  }
+  NewPC[Code.size()] = mOut.size();
+  replaceCode(NewPC);
+}
+
+void Optimizer::threadJumps() {
+  // The number of hops is bounded to stop on an endless loop of jumps.
+  auto &Code = mCF.getCode();
+  for (auto &I : Code) {
+    if (!isJump(I.Op))
+      continue;
+    for (std::size_t Hops = 0; Hops < Code.size() && I.A < Code.size() &&
+         Code[I.A].Op == Opcode::JMP; ++Hops)
+      I.A = Code[I.A].A;
+  }
+}
+
+std::optional<Instruction> Optimizer::matchFused(
+    std::size_t PC, const std::vector<bool> &IsTarget) {
+  auto &Code = mCF.getCode();
+  // The replaced sequence can only be entered at its first instruction.
+  auto fits = [&](std::size_t Length) {
+    if (PC + Length > Code.size())
+      return false;
+    for (std::size_t Idx = PC + 1; Idx < PC + Length; ++Idx)
+      if (IsTarget[Idx])
+        return false;
+    return true;
+  };
+  if (Code[PC].Op != Opcode::LOAD || !fits(3))
+    return std::nullopt;
+  auto &Left = Code[PC], &Right = Code[PC + 1], &Op = Code[PC + 2];
+  if (Right.Op == Opcode::LOAD && Op.Op == Opcode::LOAD_INDEX)
+    return Instruction{ Opcode::INDEX_LOCAL, Left.A, Right.A };
+  if (Right.Op == Opcode::LOAD && Op.Op == Opcode::STORE_INDEX)
+    return Instruction{ Opcode::STORE_INDEX_LOCAL, Left.A, Right.A };
+  if (!fits(4) ||
+      (Right.Op != Opcode::LOAD && Right.Op != Opcode::PUSH_CONST))
+    return std::nullopt;
+  bool IsConst = Right.Op == Opcode::PUSH_CONST;
+  if (isComparison(Op.Op) && isConditionalJump(Code[PC + 3].Op))
+    return Instruction{ IsConst ? Opcode::CMP_JMP_CONST :
+                        Opcode::CMP_JMP_LOCAL, Left.A, Right.A };
+  if (!fits(5) || !hasFastPath(Op.Op) || Code[PC + 3].Op != Opcode::STORE ||
+      Code[PC + 4].Op != Opcode::POP)
+    return std::nullopt;
+  if (IsConst && Op.Op == Opcode::ADD && Code[PC + 3].A == Left.A)
+    return Instruction{ Opcode::INC_LOCAL, Left.A, Right.A };
+  return Instruction{ IsConst ? Opcode::BINARY_CONST : Opcode::BINARY_LOCAL,
+                      Left.A, Right.A };
+}
+
+void Optimizer::fuseInstructions() {
+  auto &Code = mCF.getCode();
+  auto IsTarget = findTargets();
+  // Jumps to a fused sequence enter it at the fused instruction.
+  std::vector<std::size_t> NewPC(Code.size() + 1);
+  for (std::size_t PC = 0; PC < Code.size();) {
+    NewPC[PC] = mOut.size();
+    std::size_t Length = 1;
+    if (auto Fused = matchFused(PC, IsTarget)) {
+      mOut.push_back({ *Fused, mCF.getPosInfo(PC), false });
+      Length = getFusedLength(Fused->Op);
+    }
+    for (auto Idx = PC; Idx < PC + Length; ++Idx) {
+      if (Idx != PC)
+        NewPC[Idx] = mOut.size();
+      mOut.push_back({ Code[Idx], mCF.getPosInfo(Idx), false });
+    }
+    PC += Length;
+  }
+  NewPC[Code.size()] = mOut.size();
+  replaceCode(NewPC);
+}
+
+Optimizer::Optimizer(CompiledFunction &CF) : mCF(CF) {
+  foldConstants();
+  threadJumps();
+  fuseInstructions();
+}
\ No newline at end of file
@@ -0,0 +1,431 @@
+#include "dragon/analysis/ProgramCache.h"
+#include "dragon/analysis/Builtins.h"
+#include "dragon/structures/MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace {
+
+constexpr char Magic[4] = { 'D', 'R', 'C', '\0' };
+// Bump on every change of the layout below or of the meaning of opcodes.
+constexpr std::uint32_t FormatVersion = 6;
+
+struct FileHeader {
+  char Magic[4];
+  std::uint32_t Version;
+  std::uint64_t SourceHash;
+  // Hash of everything after the header, catches truncated files.
+  std::uint64_t PayloadHash;
+  std::uint64_t Size;
+  std::uint32_t OptLevel;
+  std::uint32_t FuncCount;
+  std::uint32_t OpcodeCount;
+  std::uint32_t InstructionSize;
+};
+
+struct StrRecord {
+  std::uint64_t Offset;
+  std::uint64_t Length;
+};
+
+struct FuncRecord {
+  StrRecord Name;
+  std::uint64_t ParamCount;
+  std::uint64_t LocalCount;
+  std::uint64_t CodeCount;
+  std::uint64_t ConstCount;
+  std::uint64_t LocalsOffset;
+  std::uint64_t CodeOffset;
+  std::uint64_t PosOffset;
+  std::uint64_t ConstOffset;
+};
+
+struct PosRecord {
+  std::uint64_t Line;
+  std::uint64_t Column;
+};
+
+struct ConstRecord {
+  std::uint64_t Type;
+  // Integer, bits of a float, boolean or offset of the string data.
+  std::uint64_t Bits;
+  std::uint64_t Length;
+};
+
+static_assert(std::is_trivially_copyable_v<Instruction>,
+              "Instructions are stored as raw bytes!");
+
+constexpr std::size_t SectionAlign = 8;
+
+std::uint64_t mix(std::uint64_t X) {
+  X ^= X >> 31;
+  X *= 0xbf58476d1ce4e5b9ULL;
+  X ^= X >> 27;
+  return X;
+}
+
+std::uint64_t hashBytes(const char *Data, std::size_t Size) {
+  std::uint64_t Hash = 0x9e3779b97f4a7c15ULL ^ Size;
+  std::size_t I = 0;
+  for (; I + 8 <= Size; I += 8) {
+    std::uint64_t Word;
+    std::memcpy(&Word, Data + I, 8);
+    Hash = (Hash ^ mix(Word)) * 0x94d049bb133111ebULL;
+  }
+  std::uint64_t Tail = 0;
+  if (Size > I)
+    std::memcpy(&Tail, Data + I, Size - I);
+  Hash = (Hash ^ mix(Tail)) * 0x94d049bb133111ebULL;
+  return mix(Hash);
+}
+
+// Builds the file in memory, every section starts 8-byte aligned.
+class Writer {
+public:
+  std::uint64_t reserve(std::size_t Size) {
+    auto Aligned = (mBuf.size() + SectionAlign - 1) / SectionAlign;
+    mBuf.resize(Aligned * SectionAlign);
+    auto Offset = mBuf.size();
+    mBuf.resize(Offset + Size);
+    return Offset;
+  }
+  template <typename T>
+  std::uint64_t append(const T *Data, std::size_t Count) {
+    auto Offset = reserve(sizeof(T) * Count);
+    if (Count)
+      std::memcpy(&mBuf[Offset], Data, sizeof(T) * Count);
+    return Offset;
+  }
+  StrRecord appendString(std::string_view Str) {
+    return { append(Str.data(), Str.size()), Str.size() };
+  }
+  template <typename T> void put(std::uint64_t Offset, const T &Data) {
+    std::memcpy(&mBuf[Offset], &Data, sizeof(T));
+  }
+  std::string &getBuffer() { return mBuf; }
+private:
+  std::string mBuf;
+};
+
+// Bounds-checked view of a mapped cache file.
+class Reader {
+public:
+  Reader(std::string_view Data) : mData(Data) {}
+  template <typename T>
+  const T *get(std::uint64_t Offset, std::uint64_t Count=1) const {
+    if (Offset % alignof(T) || Offset > mData.size() ||
+        Count > (mData.size() - Offset) / sizeof(T))
+      return nullptr;
+    return reinterpret_cast<const T *>(mData.data() + Offset);
+  }
+  std::optional<std::string_view> getString(const StrRecord &Str) const {
+    if (Str.Offset > mData.size() || Str.Length > mData.size() - Str.Offset)
+      return std::nullopt;
+    return mData.substr(Str.Offset, Str.Length);
+  }
+private:
+  std::string_view mData;
+};
+
+bool readFunction(const Reader &R, const FuncRecord &Rec,
+                  Compiler::FuncList &Funcs) {
+  auto Name = R.getString(Rec.Name);
+  auto *Locals = R.get<StrRecord>(Rec.LocalsOffset, Rec.LocalCount);
+  auto *Code = R.get<Instruction>(Rec.CodeOffset, Rec.CodeCount);
+  auto *Positions = R.get<PosRecord>(Rec.PosOffset, Rec.CodeCount);
+  auto *Consts = R.get<ConstRecord>(Rec.ConstOffset, Rec.ConstCount);
+  if (!Name || !Locals || !Code || !Positions || !Consts ||
+      Rec.ParamCount > Rec.LocalCount || !Rec.CodeCount)
+    return false;
+  auto &CF = Funcs.emplace_back(std::string(*Name));
+  for (std::size_t I = 0; I < Rec.LocalCount; ++I) {
+    auto Local = R.getString(Locals[I]);
+    if (!Local)
+      return false;
+    if (I < Rec.ParamCount)
+      CF.addParam(*Local);
+    else
+      CF.addLocal(*Local);
+  }
+  CompiledFunction::CodeList CodeList(Code, Code + Rec.CodeCount);
+  for (auto &I : CodeList)
+    if (I.Op > LastOpcode)
+      return false;
+  std::vector<PosInfo> PosList;
+  PosList.reserve(Rec.CodeCount);
+  for (std::size_t I = 0; I < Rec.CodeCount; ++I)
+    PosList.emplace_back(Positions[I].Line, Positions[I].Column);
+  CF.setCode(std::move(CodeList), std::move(PosList));
+  for (std::size_t I = 0; I < Rec.ConstCount; ++I) {
+    auto &Const = Consts[I];
+    switch (Const.Type) {
+    case Value::NIL:
+      CF.addConstant(Value());
+      break;
+    case Value::INTEGER:
+      CF.addConstant(Value(static_cast<std::int64_t>(Const.Bits)));
+      break;
+    case Value::FLOAT: {
+      double Float;
+      std::memcpy(&Float, &Const.Bits, sizeof(Float));
+      CF.addConstant(Value(Float));
+      break;
+    }
+    case Value::BOOLEAN:
+      CF.addConstant(Value(Const.Bits != 0));
+      break;
+    case Value::STRING: {
+      auto Str = R.getString({ Const.Bits, Const.Length });
+      // Equal strings share one constant, a cache never lists one twice.
+      if (!Str || CF.addString(*Str) != I)
+        return false;
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+// Whether every operand of the code lies within the table it indexes, and
+// fused instructions are followed by the sequence they replace. A damaged
+// file or one written with other meanings for the opcodes then cannot make
+// the interpreter read out of bounds. Stack effects are not checked, the
+// cache is trusted to hold code the compiler produced.
+bool checkCode(const CompiledFunction &CF, bool IsGlobal,
+               std::size_t GlobalIdx, const Compiler::FuncList &Funcs) {
+  auto &Code = CF.getCode();
+  std::uint64_t Size = Code.size(), Locals = CF.getFrameSize(),
+                Consts = CF.getConstantCount(),
+                Globals = Funcs[GlobalIdx].getFrameSize();
+  for (std::size_t PC = 0; PC < Size; ++PC) {
+    auto &I = Code[PC];
+    bool Valid = true;
+    switch (I.Op) {
+    case Opcode::PUSH_CONST:
+      Valid = I.A < Consts;
+      break;
+    case Opcode::LOAD:
+    case Opcode::STORE:
+      Valid = I.A < Locals;
+      break;
+    case Opcode::LOAD_GLOBAL:
+    case Opcode::STORE_GLOBAL:
+    case Opcode::GLOBAL:
+      Valid = I.A < Globals;
+      break;
+    case Opcode::TAIL_CALL:
+      Valid = !IsGlobal && I.A < Funcs.size() && I.A != GlobalIdx;
+      break;
+    case Opcode::CALL:
+      Valid = I.A < Funcs.size() && I.A != GlobalIdx;
+      break;
+    case Opcode::CALL_NATIVE:
+      Valid = I.A < getBuiltinCount();
+      break;
+    case Opcode::JMP:
+    case Opcode::JMP_IF:
+    case Opcode::JMP_IF_FALSE:
+      Valid = I.A < Size;
+      break;
+    case Opcode::FOR_PREP:
+      Valid = I.A + std::uint64_t(1) < Locals;
+      break;
+    case Opcode::FOR_NEXT:
+      Valid = I.A < Size && I.B + std::uint64_t(1) < Locals;
+      break;
+    case Opcode::INC_LOCAL:
+    case Opcode::CMP_JMP_CONST:
+    case Opcode::BINARY_CONST:
+      Valid = I.A < Locals && I.B < Consts;
+      break;
+    case Opcode::CMP_JMP_LOCAL:
+    case Opcode::BINARY_LOCAL:
+    case Opcode::INDEX_LOCAL:
+    case Opcode::STORE_INDEX_LOCAL:
+      Valid = I.A < Locals && I.B < Locals;
+      break;
+    default:
+      break;
+    }
+    // The fast paths read the operator, the jump and the assigned slot from
+    // the replaced instructions.
+    if (auto Length = getFusedLength(I.Op)) {
+      Valid = Valid && PC + Length < Size;
+      if (Valid && (I.Op == Opcode::CMP_JMP_LOCAL ||
+                    I.Op == Opcode::CMP_JMP_CONST))
+        Valid = Code[PC + 3].Op >= Opcode::EQ &&
+                Code[PC + 3].Op <= Opcode::GE &&
+                (Code[PC + 4].Op == Opcode::JMP_IF ||
+                 Code[PC + 4].Op == Opcode::JMP_IF_FALSE);
+      else if (Valid && Length == 5)
+        Valid = Code[PC + 4].Op == Opcode::STORE;
+    }
+    if (!Valid)
+      return false;
+  }
+  // Execution must not run off the end of the code.
+  auto Last = Code.back().Op;
+  return Last == Opcode::RET || Last == Opcode::RET_VOID ||
+         Last == Opcode::JMP || Last == Opcode::TAIL_CALL;
+}
+
+} // namespace
+
+std::uint64_t ProgramCache::hashSource(std::string_view Source) {
+  return hashBytes(Source.data(), Source.size());
+}
+
+std::string ProgramCache::getCachePath(std::string_view SourcePath) {
+  std::string Path(SourcePath);
+  if (Path.size() > 3 && Path.compare(Path.size() - 3, 3, ".dr") == 0)
+    return Path + "c";
+  return Path + ".drc";
+}
+
+void ProgramCache::write(const std::string &Path, std::uint64_t SourceHash,
+                         unsigned OptLevel, const Compiler::FuncList &Funcs) {
+  Writer W;
+  auto HeaderOffset = W.reserve(sizeof(FileHeader));
+  auto FuncsOffset = W.reserve(sizeof(FuncRecord) * Funcs.size());
+  for (std::size_t Idx = 0; Idx < Funcs.size(); ++Idx) {
+    auto &CF = Funcs[Idx];
+    auto &Code = CF.getCode();
+    FuncRecord Rec {};
+    Rec.Name = W.appendString(CF.getName());
+    Rec.ParamCount = CF.getParamCount();
+    Rec.LocalCount = CF.getFrameSize();
+    Rec.CodeCount = Code.size();
+    Rec.ConstCount = CF.getConstantCount();
+    std::vector<StrRecord> Locals;
+    for (std::uint32_t Slot = 0; Slot < CF.getFrameSize(); ++Slot)
+      Locals.push_back(W.appendString(CF.getLocalName(Slot)));
+    Rec.LocalsOffset = W.append(Locals.data(), Locals.size());
+    // Padding inside instructions is zeroed, so equal programs give equal
+    // files.
+    Rec.CodeOffset = W.reserve(sizeof(Instruction) * Code.size());
+    for (std::size_t PC = 0; PC < Code.size(); ++PC) {
+      Instruction I;
+      std::memset(&I, 0, sizeof(I));
+      I.Op = Code[PC].Op;
+      I.A = Code[PC].A;
+      I.B = Code[PC].B;
+      W.put(Rec.CodeOffset + PC * sizeof(Instruction), I);
+    }
+    std::vector<PosRecord> Positions;
+    for (std::size_t PC = 0; PC < Code.size(); ++PC) {
+      auto &PI = CF.getPosInfo(PC);
+      Positions.push_back({ PI.first, PI.second });
+    }
+    Rec.PosOffset = W.append(Positions.data(), Positions.size());
+    std::vector<ConstRecord> Consts;
+    for (std::uint32_t I = 0; I < CF.getConstantCount(); ++I) {
+      auto &Val = CF.getConstant(I);
+      ConstRecord Const { Val.getType(), 0, 0 };
+      switch (Val.getType()) {
+      case Value::NIL:
+        break;
+      case Value::INTEGER:
+        Const.Bits = static_cast<std::uint64_t>(Val.getInt());
+        break;
+      case Value::FLOAT: {
+        double Float = Val.getFloat();
+        std::memcpy(&Const.Bits, &Float, sizeof(Float));
+        break;
+      }
+      case Value::BOOLEAN:
+        Const.Bits = Val.getBool();
+        break;
+      case Value::STRING: {
+        auto Str = W.appendString(Val.getString());
+        Const.Bits = Str.Offset;
+        Const.Length = Str.Length;
+        break;
+      }
+      case Value::BIGINT:
+      case Value::ARRAY:
+      case Value::DICT:
+        assert(0 && "Constants never hold big integers, arrays or dicts!");
+        break;
+      }
+      Consts.push_back(Const);
+    }
+    Rec.ConstOffset = W.append(Consts.data(), Consts.size());
+    W.put(FuncsOffset + Idx * sizeof(FuncRecord), Rec);
+  }
+
+  auto &Buf = W.getBuffer();
+  FileHeader Header {};
+  std::memcpy(Header.Magic, Magic, sizeof(Magic));
+  Header.Version = FormatVersion;
+  Header.SourceHash = SourceHash;
+  Header.PayloadHash = hashBytes(Buf.data() + sizeof(FileHeader),
+                                 Buf.size() - sizeof(FileHeader));
+  Header.Size = Buf.size();
+  Header.OptLevel = OptLevel;
+  Header.FuncCount = Funcs.size();
+  Header.OpcodeCount = static_cast<std::uint32_t>(LastOpcode) + 1;
+  Header.InstructionSize = sizeof(Instruction);
+  W.put(HeaderOffset, Header);
+
+  // Written aside and renamed, so a reader never sees a partial file.
+  auto TmpPath = Path + ".tmp";
+  {
+    std::ofstream File(TmpPath, std::ios::binary | std::ios::trunc);
+    if (!File.write(Buf.data(), Buf.size()) || !File.flush())
+      throw CacheException("Failed to write compiled program `" + TmpPath +
+                           "`");
+  }
+  if (std::rename(TmpPath.c_str(), Path.c_str()) != 0) {
+    std::remove(TmpPath.c_str());
+    throw CacheException("Failed to write compiled program `" + Path + "`");
+  }
+}
+
+std::optional<Compiler::FuncList> ProgramCache::load(
+    const std::string &Path, std::uint64_t SourceHash, unsigned OptLevel) {
+  MappedFile File(Path.c_str());
+  if (!File.isOpen())
+    return std::nullopt;
+  Reader R(File.getView());
+  auto *Header = R.get<FileHeader>(0);
+  if (!Header || std::memcmp(Header->Magic, Magic, sizeof(Magic)) ||
+      Header->Version != FormatVersion ||
+      Header->OpcodeCount != static_cast<std::uint32_t>(LastOpcode) + 1 ||
+      Header->InstructionSize != sizeof(Instruction) ||
+      Header->SourceHash != SourceHash || Header->OptLevel != OptLevel ||
+      Header->Size != File.getView().size() || Header->FuncCount == 0)
+    return std::nullopt;
+  if (Header->PayloadHash != hashBytes(File.getView().data() +
+                                       sizeof(FileHeader),
+                                       Header->Size - sizeof(FileHeader))) {
+    DRAGON_DEBUG(dbgs() << "[CACHE] Corrupted compiled program `" << Path <<
+                 "`.\n");
+    return std::nullopt;
+  }
+  auto *Recs = R.get<FuncRecord>(sizeof(FileHeader), Header->FuncCount);
+  if (!Recs)
+    return std::nullopt;
+  Compiler::FuncList Funcs;
+  Funcs.reserve(Header->FuncCount);
+  for (std::size_t Idx = 0; Idx < Header->FuncCount; ++Idx)
+    if (!readFunction(R, Recs[Idx], Funcs))
+      return std::nullopt;
+  // The interpreter runs the first function with the global name.
+  auto Global = std::find_if(Funcs.begin(), Funcs.end(), [](auto &CF) {
+    return CF.getName() == GLOBAL_FUNC;
+  });
+  if (Global == Funcs.end())
+    return std::nullopt;
+  std::size_t GlobalIdx = Global - Funcs.begin();
+  for (std::size_t Idx = 0; Idx < Funcs.size(); ++Idx)
+    if (!checkCode(Funcs[Idx], Idx == GlobalIdx, GlobalIdx, Funcs))
+      return std::nullopt;
+  DRAGON_DEBUG(dbgs() << "[CACHE] Loaded " << Funcs.size() <<
+               " functions from `" << Path << "`.\n");
+  return Funcs;
+}
\ No newline at end of file
@@ -1,17 +1,31 @@
 #include "dragon/analysis/SyntaxAnalyzer.h"
+#include "dragon/analysis/Builtins.h"
 #include <algorithm>
+#include <limits>
 #include <stack>
 
 typedef LexicalAnalyzer::TokenList TokenList;
-typedef SyntaxAnalyzer::FuncMap FuncMap;
 
+std::optional<std::size_t> SyntaxAnalyzer::findFunction(
+    std::string_view Name) const {
+  auto Itr = mFuncIndices.find(Name);
+  if (Itr == mFuncIndices.end())
+    return std::nullopt;
+  return Itr->second;
+}
 
 void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
   typedef std::pair<Keyword *, std::size_t> IfWhilePos;
   typedef std::vector<Token *>::const_iterator TokenIterator;
-  auto isFunction = [this, &F](const Identifier *Id) {
-    return mFuncMap.find(Id->getName()) != mFuncMap.end() ||
-           F.getName() == Id->getName();
+  // A function sees itself and the functions declared before it, the global
+  // code sees all of them.
+  auto getFunctionIndex = [this, &F](const Identifier *Id) {
+    if (F.getName() == Id->getName())
+      return std::optional<std::size_t>(F.getIndex());
+    auto Idx = findFunction(Id->getName());
+    if (Idx && F.getIndex() != 0 && *Idx >= F.getIndex())
+      return std::optional<std::size_t>();
+    return Idx;
   };
   auto generateNotGoto = [this](const PostfixList &PL)->
       std::vector<Token *> {
@@ -31,23 +45,78 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
         std::make_unique<Integer>(PL.size())).get();
     return { PosPtr, GotoPtr };
   };
+  auto makeToken = [this](std::unique_ptr<Token> Tok) {
+    return mTmpTokens.emplace_back(std::move(Tok)).get();
+  };
+  auto isLeftParenthesis = [](const Token *Tok) {
+    auto Br = dyn_cast<Bracket>(Tok);
+    return Br && Br->getKind() == Keyword::Kind::LEFT_PARENTHESIS;
+  };
+  // Whether the token ends an operand, so that `-` after it subtracts and
+  // `[` after it indexes.
+  auto endsOperand = [](const Token *Tok) {
+    if (isa<Identifier>(Tok) || isa<Constant>(Tok))
+      return true;
+    auto Br = dyn_cast<Bracket>(Tok);
+    return Br && (Br->getKind() == Keyword::Kind::RIGHT_PARENTHESIS ||
+                  Br->getKind() == Keyword::Kind::RIGHT_SQUARE_BRACKET);
+  };
+  // An open `[`: either an index or slice of the operand before it, or an
+  // array literal. Last is the bracket or the latest separator inside.
+  struct SquareInfo {
+    bool IsIndex;
+    bool HasColon;
+    unsigned Count;
+    TokenIterator Last;
+  };
   std::stack<IfWhilePos> IfWhileStack;
   auto &PostfixList = F.getPostfixList();
   for (auto Itr = TL.begin(); Itr != TL.end(); ++Itr) {
     auto &Line = PostfixList.emplace_back();
     std::stack<Token *> Stack;
     std::stack<std::pair<unsigned, TokenIterator>> ArgCountStack;
+    std::stack<SquareInfo> SquareStack;
+    // Variable of a `for` header, its step line follows the header.
+    Identifier *LoopVar = nullptr;
+    // Moves operators to the output up to the innermost open bracket, which
+    // is returned, or nullptr if there is none.
+    auto popToBracket = [&Stack, &Line]() -> Bracket * {
+      while (!Stack.empty()) {
+        if (auto Br = dyn_cast<Bracket>(Stack.top()))
+          return Br;
+        Line.push_back(Stack.top());
+        Stack.pop();
+      }
+      return nullptr;
+    };
     for (auto TokenItr = Itr->begin(); TokenItr != Itr->end(); ++TokenItr) {
       auto &TokenPtr = *TokenItr;
-      if (dynamic_cast<Constant *>(TokenPtr)) {
+      switch (TokenPtr->getTokenKind()) {
+      case TokenKind::STRING:
+      case TokenKind::FLOAT:
+      case TokenKind::INTEGER:
+      case TokenKind::BOOLEAN:
         Line.push_back(TokenPtr);
-      } else if (auto Id = dynamic_cast<Identifier *>(TokenPtr)) {
-        if (isFunction(Id)) {
-          Stack.push(Id);
-          auto Next = std::next(TokenItr);
+        break;
+      case TokenKind::IDENTIFIER: {
+        auto Id = cast<Identifier>(TokenPtr);
+        auto Next = std::next(TokenItr);
+        Identifier *Call = nullptr;
+        if (auto FuncIdx = getFunctionIndex(Id)) {
+          Call = cast<Identifier>(makeToken(std::make_unique<FunctionCall>(
+              Id->getName(), *FuncIdx, Id->getPosInfo())));
+        } else if (auto BuiltinIdx = findBuiltin(Id->getName());
+                   BuiltinIdx && !findFunction(Id->getName()) &&
+                   Next != Itr->end() && isLeftParenthesis(*Next)) {
+          // A builtin name stays free for variables, it's only a call when
+          // followed by `(`.
+          Call = cast<Identifier>(makeToken(std::make_unique<BuiltinCall>(
+              Id->getName(), *BuiltinIdx, Id->getPosInfo())));
+        }
+        if (Call) {
+          Stack.push(Call);
           if (Next != Itr->end()) {
-            if (auto LeftPar = dynamic_cast<Bracket *>(*Next); LeftPar &&
-                LeftPar->getKind() == Keyword::Kind::LEFT_PARENTHESIS) {
+            if (isLeftParenthesis(*Next)) {
               DRAGON_DEBUG(dbgs() << "[SYNTAX ANALYZER] Initialize function "
                   "call info stack for function `" << Id->toString() << "`\n");
               ArgCountStack.push(std::make_pair(0, Next));
@@ -62,12 +131,15 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
         } else {
           Line.push_back(Id);
         }
-      } else if (auto Pref = dynamic_cast<PrefixOperator *>(TokenPtr)) {
+        break;
+      }
+      case TokenKind::PREFIX_OPERATOR: {
+        auto Pref = cast<PrefixOperator>(TokenPtr);
         if (Pref->getKind() == Keyword::Kind::GLOBAL) {
           auto Next = std::next(TokenItr);
           if (TokenItr != Itr->begin() || Next == Itr->end())
             throw SyntaxException("Syntax error at " + TokenPtr->getPos());
-          auto NextId = dynamic_cast<Identifier *>(*Next);
+          auto NextId = dyn_cast<Identifier>(*Next);
           if (!NextId)
             throw SyntaxException("Identifier expected after `global` at " +
                                   TokenPtr->getPos());
@@ -76,8 +148,28 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
                                   TokenPtr->getPos());
           Line.push_back(NextId);
           Line.push_back(TokenPtr);
-          break;
-        } if (Pref->getKind() == Keyword::Kind::COMMA) {
+          // The identifier is consumed as well, it ends the line.
+          TokenItr = Next;
+        } else if (Pref->getKind() == Keyword::Kind::COMMA) {
+          if (ArgCountStack.empty() && SquareStack.empty())
+            throw SyntaxException("No function call for comma at " +
+                                  Pref->getPos());
+          auto Br = popToBracket();
+          if (!Br)
+            throw SyntaxException("Bracket mismatch or missed comma at " +
+                                  Pref->getPos());
+          if (Br->getKind() == Keyword::Kind::LEFT_SQUARE_BRACKET) {
+            auto &Info = SquareStack.top();
+            if (Info.IsIndex)
+              throw SyntaxException("Unexpected comma in index at " +
+                                    Pref->getPos());
+            if (std::next(Info.Last) == TokenItr)
+              throw SyntaxException("Empty element of array at " +
+                                    Pref->getPos());
+            ++Info.Count;
+            Info.Last = TokenItr;
+            break;
+          }
           if (ArgCountStack.empty())
             throw SyntaxException("No function call for comma at " +
                                   Pref->getPos());
@@ -86,19 +178,20 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
                                   Pref->getPos());
           ++ArgCountStack.top().first;
           ArgCountStack.top().second = TokenItr;
-          bool HasLeftBr = false;
-          while (!Stack.empty()) {
-            if (auto Kw = dynamic_cast<Bracket *>(Stack.top());
-                Kw && Kw->getKind() == Keyword::Kind::LEFT_PARENTHESIS) {
-              HasLeftBr = true;
-              break;
-            }
-            Line.push_back(Stack.top());
-            Stack.pop();
-          }
-          if (!HasLeftBr)
-            throw SyntaxException("Bracket mismatch or missed comma at " +
-                                  Pref->getPos());
+        } else if (Pref->getKind() == Keyword::Kind::COLON) {
+          if (SquareStack.empty() || !SquareStack.top().IsIndex ||
+              SquareStack.top().HasColon)
+            throw SyntaxException("Unexpected colon at " + Pref->getPos());
+          auto Br = popToBracket();
+          if (!Br || Br->getKind() != Keyword::Kind::LEFT_SQUARE_BRACKET)
+            throw SyntaxException("Bracket mismatch at " + Pref->getPos());
+          auto &Info = SquareStack.top();
+          // An omitted lower bound starts the slice at the first element.
+          if (std::next(Info.Last) == TokenItr)
+            Line.push_back(makeToken(std::make_unique<Integer>(0,
+                           Pref->getPosInfo())));
+          Info.HasColon = true;
+          Info.Last = TokenItr;
         } else if (Pref->getKind() == Keyword::Kind::IF ||
                    Pref->getKind() == Keyword::Kind::WHILE) {
           IfWhileStack.push(std::make_pair(Pref, PostfixList.size() - 1));
@@ -133,6 +226,40 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
                                         GotoList.begin(), GotoList.end());
           }
           IfWhileStack.pop();
+        } else if (Pref->getKind() == Keyword::Kind::FOR) {
+          // `for x in expr`: the variable and `in` are taken here, the
+          // header line only evaluates the iterable.
+          auto Var = std::next(TokenItr);
+          if (TokenItr != Itr->begin() || Var == Itr->end() ||
+              std::next(Var) == Itr->end())
+            throw SyntaxException("Syntax error at " + TokenPtr->getPos());
+          LoopVar = dyn_cast<Identifier>(*Var);
+          if (!LoopVar || getFunctionIndex(LoopVar))
+            throw SyntaxException("Variable expected after `for` at " +
+                                  TokenPtr->getPos());
+          auto In = dyn_cast<BinaryOperator>(*std::next(Var));
+          if (!In || In->getKind() != Keyword::Kind::IN)
+            throw SyntaxException("`in` expected after the variable of `for` "
+                                  "at " + (*std::next(Var))->getPos());
+          TokenItr = std::next(Var);
+          Stack.push(Pref);
+        } else if (Pref->getKind() == Keyword::Kind::ENDFOR) {
+          if (IfWhileStack.empty() ||
+              IfWhileStack.top().first->getKind() != Keyword::Kind::FOR)
+            throw SyntaxException("No `for` for `endfor` at " +
+                                  Pref->getPos());
+          auto For = IfWhileStack.top().first;
+          auto StepPos = IfWhileStack.top().second;
+          // The step leaves the loop past the `endfor` line.
+          auto &Step = PostfixList[StepPos];
+          Step.push_back(makeToken(std::make_unique<Integer>(
+              PostfixList.size(), For->getPosInfo())));
+          Step.push_back(makeToken(std::make_unique<BinaryOperator>(
+              Keyword::Kind::FOR_NEXT, For->getPosInfo())));
+          Line.push_back(makeToken(std::make_unique<Integer>(StepPos)));
+          Line.push_back(makeToken(std::make_unique<PrefixOperator>(
+              Keyword::Kind::GOTO_UN)));
+          IfWhileStack.pop();
         } else if (Pref->getKind() == Keyword::Kind::ENDWHILE) {
           if (IfWhileStack.empty())
             throw SyntaxException("No `while` for `endwhile` at " +
@@ -155,30 +282,64 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
         } else {
           Stack.push(Pref);
         }
-      } else if (auto Br = dynamic_cast<Bracket *>(TokenPtr)) {
+        break;
+      }
+      case TokenKind::BRACKET: {
+        auto Br = cast<Bracket>(TokenPtr);
         if (Br->getKind() == Keyword::Kind::LEFT_PARENTHESIS) {
           Stack.push(Br);
+        } else if (Br->getKind() == Keyword::Kind::LEFT_SQUARE_BRACKET) {
+          bool IsIndex = TokenItr != Itr->begin() &&
+                         endsOperand(*std::prev(TokenItr));
+          SquareStack.push({ IsIndex, false, 0, TokenItr });
+          Stack.push(Br);
+        } else if (Br->getKind() == Keyword::Kind::RIGHT_SQUARE_BRACKET) {
+          auto Open = popToBracket();
+          if (SquareStack.empty() || !Open ||
+              Open->getKind() != Keyword::Kind::LEFT_SQUARE_BRACKET)
+            throw SyntaxException("Bracket mismatch at " + Br->getPos());
+          Stack.pop();
+          auto Info = SquareStack.top();
+          SquareStack.pop();
+          bool Empty = std::next(Info.Last) == TokenItr;
+          auto &PI = Open->getPosInfo();
+          if (Info.IsIndex && !Info.HasColon) {
+            if (Empty)
+              throw SyntaxException("Index expected at " + Br->getPos());
+            Line.push_back(makeToken(std::make_unique<BinaryOperator>(
+                Keyword::Kind::INDEX, PI)));
+          } else if (Info.IsIndex) {
+            // An omitted upper bound ends the slice at the last element.
+            if (Empty)
+              Line.push_back(makeToken(std::make_unique<Integer>(
+                  std::numeric_limits<std::int64_t>::max(), PI)));
+            Line.push_back(makeToken(std::make_unique<PrefixOperator>(
+                Keyword::Kind::SLICE, PI)));
+          } else {
+            if (Empty && Info.Count > 0)
+              throw SyntaxException("Empty element of array at " +
+                                    Br->getPos());
+            if (!Empty)
+              ++Info.Count;
+            Line.push_back(makeToken(std::make_unique<Integer>(Info.Count,
+                                                               PI)));
+            Line.push_back(makeToken(std::make_unique<PrefixOperator>(
+                Keyword::Kind::MAKE_ARRAY, PI)));
+          }
         } else if (Br->getKind() == Keyword::Kind::RIGHT_PARENTHESIS) {
           if (Stack.empty())
             throw SyntaxException("Bracket mismatch at " + Br->getPos());
-          while (!Stack.empty()) {
-            auto TopToken = dynamic_cast<Bracket *>(Stack.top());
-            if (TopToken &&
-                TopToken->getKind() == Keyword::Kind::LEFT_PARENTHESIS)
-              break;
-            Line.push_back(Stack.top());
-            Stack.pop();
-          }
+          popToBracket();
           if (!Stack.empty()) {
-            auto TopToken = dynamic_cast<Bracket *>(Stack.top());
+            auto TopToken = dyn_cast<Bracket>(Stack.top());
             if (!TopToken ||
                 TopToken->getKind() != Keyword::Kind::LEFT_PARENTHESIS)
               throw SyntaxException("Bracket mismatch at " + Br->getPos());
             else
               Stack.pop();
             if (!Stack.empty()) {
-              if (auto Id = dynamic_cast<Identifier *>(Stack.top())) {
-                if (isFunction(Id)) {
+              if (auto Id = dyn_cast<Identifier>(Stack.top())) {
+                if (isa<FunctionCall>(Id) || isa<BuiltinCall>(Id)) {
                   if (ArgCountStack.empty())
                     throw SyntaxException("No function call for ')' at " +
                                           Id->getPos());
@@ -190,12 +351,14 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
                     ++ArgInfo.first;
                   }
                   ArgInfo.second = TokenItr;
-                  std::size_t ExpectedParamCount = 0;
-                  if (Id->getName() == F.getName()) {
-                    ExpectedParamCount = F.getParamList().size();
+                  std::size_t ExpectedParamCount;
+                  if (auto Call = dyn_cast<FunctionCall>(Id)) {
+                    auto &Callee = Call->getIndex() == F.getIndex() ?
+                        F : mFuncs[Call->getIndex()];
+                    ExpectedParamCount = Callee.getParamList().size();
                   } else {
-                    ExpectedParamCount = mFuncMap.find(Id->getName())->
-                        second.getParamList().size();
+                    ExpectedParamCount = getBuiltin(
+                        cast<BuiltinCall>(Id)->getIndex()).ParamCount;
                   }
                   DRAGON_DEBUG(dbgs() << "[SYNTAX ANALYZER] Expected/real "
                       "argument count for function `" << Id->getName() <<
@@ -218,16 +381,14 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
             }
           }
         }
-      } else if (auto Bin = dynamic_cast<BinaryOperator *>(TokenPtr)) {
+        break;
+      }
+      case TokenKind::BINARY_OPERATOR: {
+        auto Bin = cast<BinaryOperator>(TokenPtr);
         if (Bin->getKind() == Keyword::Kind::MINUS ||
             Bin->getKind() == Keyword::Kind::PLUS) {
-          auto PrevToken = std::prev(TokenItr);
           if (TokenItr == Itr->begin() ||
-              (!dynamic_cast<Identifier *>(*PrevToken) &&
-              !dynamic_cast<Constant *>(*PrevToken) &&
-              !(dynamic_cast<Bracket *>(*PrevToken) &&
-              dynamic_cast<Bracket *>(*PrevToken)->getKind() ==
-              Keyword::Kind::RIGHT_PARENTHESIS))) {
+              !endsOperand(*std::prev(TokenItr))) {
             Token *UnaryPtr = nullptr;
             if (Bin->getKind() == Keyword::Kind::MINUS) {
               UnaryPtr = mTmpTokens.emplace_back(
@@ -243,15 +404,14 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
           }
         }
         while (!Stack.empty()) {
-          auto Kw = dynamic_cast<Keyword *>(Stack.top());
-          assert(Kw && "Stack must contain keyword only!");
-          if (dynamic_cast<Bracket *>(Kw))
+          auto Kw = cast<Keyword>(Stack.top());
+          if (isa<Bracket>(Kw))
             break;
           if (Kw->getPriority() < Bin->getPriority()) {
             Line.push_back(Kw);
             Stack.pop();
           } else if (Kw->getPriority() == Bin->getPriority()) {
-            auto BinKw = dynamic_cast<BinaryOperator *>(Kw);
+            auto BinKw = dyn_cast<BinaryOperator>(Kw);
             if (!BinKw)
               break;
             if (BinKw->getAssocKind() == BinaryOperator::AssocKind::LEFT) {
@@ -265,34 +425,58 @@ void SyntaxAnalyzer::generatePostfix(const TokenPtrList &TL, Function &F) {
           }
         }
         Stack.push(Bin);
-      } else {
+        break;
+      }
+      default:
         throw SyntaxException("Unexpected token at " + TokenPtr->getPos());
       }
     }
     DRAGON_DEBUG(dbgs() << "[SYNTAX ANALYZER] In stack after line processing:\n");
     while (!Stack.empty()) {
       DRAGON_DEBUG(dbgs() << Stack.top()->toString() << "\n");
-      if (dynamic_cast<Bracket *>(Stack.top())) {
+      if (isa<Bracket>(Stack.top())) {
         throw SyntaxException("Parenthesis mismatch");
       }
       Line.push_back(Stack.top());
       Stack.pop();
     }
+    if (LoopVar) {
+      // Every iteration starts at the step, which assigns the next element
+      // to the variable. `endfor` completes it with the exit.
+      PostfixList.emplace_back().push_back(LoopVar);
+      IfWhileStack.push(std::make_pair(cast<Keyword>(*Itr->begin()),
+                                       PostfixList.size() - 1));
+    }
   }
   if (!IfWhileStack.empty()) {
     auto TopToken = IfWhileStack.top().first;
     throw SyntaxException("Pair mismatch for token at " + TopToken->getPos());
   }
   PostfixList.emplace_back();
+  F.mHasPostfix = true;
+}
+
+void SyntaxAnalyzer::generateFunction(std::size_t Idx) {
+  auto &Func = mFuncs[Idx];
+  if (Func.hasPostfix())
+    return;
+  TokenPtrList TLPtr;
+  std::for_each(Func.getBodyBegin(), Func.getBodyEnd(),
+      [&TLPtr](const std::vector<std::unique_ptr<Token>> &UPV) {
+        auto &LastLine = TLPtr.emplace_back();
+        for (auto &UP : UPV)
+          LastLine.push_back(UP.get());
+      });
+  generatePostfix(TLPtr, Func);
 }
 
-SyntaxAnalyzer::SyntaxAnalyzer(const LexicalAnalyzer &LA) {
+SyntaxAnalyzer::SyntaxAnalyzer(const LexicalAnalyzer &LA, bool Lazy) {
   auto &TL = LA.getTokenList();
   auto getReturnIterator = [&TL](TokenList::const_iterator Itr) {
     for (; Itr != TL.end(); ++Itr) {
       if (Itr->empty())
         continue;
-      auto Kw = dynamic_cast<Keyword *>((*Itr)[0].get());
+      auto Kw = dyn_cast<Keyword>((*Itr)[0].get());
       if (!Kw)
         continue;
       if (Kw->getKind() == Keyword::Kind::FUNCTION)
@@ -302,40 +486,41 @@ SyntaxAnalyzer::SyntaxAnalyzer(const LexicalAnalyzer &LA) {
     }
     return Itr;
   };
-  auto &GlobF = mFuncMap.insert(std::make_pair(
-      GLOBAL_FUNC, Function(GLOBAL_FUNC))).first->second;
+  mFuncs.emplace_back(GLOBAL_FUNC, 0);
+  mFuncIndices.insert(std::make_pair(GLOBAL_FUNC, 0));
   TokenPtrList GlobalTL;
   for (auto Itr = TL.begin(); Itr != TL.end(); ++Itr) {
     auto &TokenLine = *Itr;
     if (TokenLine.empty())
       continue;
-    if (auto Kw = dynamic_cast<Keyword *>(TokenLine[0].get())) {
+    if (auto Kw = dyn_cast<Keyword>(TokenLine[0].get())) {
       if (Kw->getKind() == Keyword::Kind::FUNCTION) {
         if (TokenLine.size() < 2) {
           throw SyntaxException("Function name expected after token at " +
                                 Kw->getPos());
         }
-        if (auto Name = dynamic_cast<Identifier *>(TokenLine[1].get())) {
-          Function Func(Name->getName());
+        if (auto Name = dyn_cast<Identifier>(TokenLine[1].get())) {
+          Function Func(Name->getName(), mFuncs.size());
           assert(!Func.getName().empty() && "Function name must not be empty!");
           if (TokenLine.size() < 3) {
             throw SyntaxException("'(' expected after token at " +
                                   Name->getPos());
           }
-          if (auto KwLeftPar = dynamic_cast<Keyword *>(TokenLine[2].get());
+          if (auto KwLeftPar = dyn_cast<Keyword>(TokenLine[2].get());
+              KwLeftPar &&
               KwLeftPar->getKind() == Keyword::Kind::LEFT_PARENTHESIS) {
             if (TokenLine.size() < 4) {
-              throw SyntaxException("'(' or parameter expected after token at "+
+              throw SyntaxException("')' or parameter expected after token at "+
                                     KwLeftPar->getPos());
             }
             for (std::size_t I = 3; I < TokenLine.size(); I += 2) {
               auto Token = TokenLine[I].get();
-              if (auto ParamId = dynamic_cast<Identifier *>(Token)) {
+              if (auto ParamId = dyn_cast<Identifier>(Token)) {
                 Func.addParam(ParamId);
                 if (I + 1 == TokenLine.size())
-                  throw SyntaxException("'(' expected after token at " +
+                  throw SyntaxException("')' expected after token at " +
                                         ParamId->getPos());
-                auto KwSep = dynamic_cast<Keyword *>(TokenLine[I + 1].get());
+                auto KwSep = dyn_cast<Keyword>(TokenLine[I + 1].get());
                 if (KwSep && KwSep->getKind() ==
                     Keyword::Kind::RIGHT_PARENTHESIS) {
                   // If ')' is the last token.
@@ -345,14 +530,20 @@ SyntaxAnalyzer::SyntaxAnalyzer(const LexicalAnalyzer &LA) {
                         "at " + KwSep->getPos());
                   break;
                 } else if (KwSep && KwSep->getKind() == Keyword::Kind::COMMA) {
+                  if (I + 2 == TokenLine.size())
+                    throw SyntaxException("Identifier expected after token at "
+                                          + KwSep->getPos());
                   continue;
-                } else {
-                  assert(0 && "Unreachable line detected.");
                 }
-                assert(0 && "Unreachable line detected.");
-              } else if (auto KwSep = dynamic_cast<Keyword *>(
-                         TokenLine[I].get()); KwSep->getKind() ==
+                throw SyntaxException("',' or ')' expected after token at " +
+                                      ParamId->getPos());
+              } else if (auto KwSep = dyn_cast<Keyword>(TokenLine[I].get());
+                         KwSep && KwSep->getKind() ==
                          Keyword::Kind::RIGHT_PARENTHESIS) {
+                // Only an empty list may close right after '('.
+                if (I != 3)
+                  throw SyntaxException("Identifier expected after token at " +
+                                        TokenLine[I - 1]->getPos());
                 if (I + 1 != TokenLine.size())
                   throw SyntaxException(
                       "Extra tokens after ')' in the function declaration at " +
@@ -368,16 +559,15 @@ SyntaxAnalyzer::SyntaxAnalyzer(const LexicalAnalyzer &LA) {
                                     Func.getName() + "` declared on " +
                                     Kw->getPos() + " not found");
             }
-            TokenPtrList TLPtr;
-            std::for_each(std::next(Itr), std::next(ReturnItr),
-                [&TLPtr](const std::vector<std::unique_ptr<Token>> &UPV) {
-                  auto &LastLine = TLPtr.emplace_back();
-                  for (auto &UP : UPV)
-                    LastLine.push_back(UP.get());
-                });
-            generatePostfix(TLPtr, Func);
+            Func.setBody(std::next(Itr), std::next(ReturnItr));
+            if (ReturnItr->size() > 1)
+              Func.setReturnsValue();
             Itr = ReturnItr;
-            mFuncMap.insert(std::make_pair(Func.getName(), std::move(Func)));
+            mFuncIndices.insert(std::make_pair(Func.getName(),
+                                               Func.getIndex()));
+            mFuncs.push_back(std::move(Func));
+            if (!Lazy)
+              generateFunction(mFuncs.size() - 1);
           } else {
             throw SyntaxException("'(' expected after token at " +
                                   Name->getPos());
@@ -399,25 +589,29 @@ SyntaxAnalyzer::SyntaxAnalyzer(const LexicalAnalyzer &LA) {
         LineGL.push_back(UP.get());
     }
   }
-  generatePostfix(GlobalTL, GlobF);
+  generatePostfix(GlobalTL, mFuncs[0]);
   DRAGON_DEBUG(dump());
 }
 
 void SyntaxAnalyzer::dump() const {
   dbgs() << "[SYNTAX ANALYZER] Postfix form for functions:\n";
-  for (auto &Pair : mFuncMap) {
-    dbgs() << "Function `" << Pair.first << "`:\n";
+  for (auto &Func : mFuncs) {
+    dbgs() << "Function `" << Func.getName() << "`:\n";
     dbgs() << "Parameters: (";
-    const auto &ParamList = Pair.second.getParamList();
+    const auto &ParamList = Func.getParamList();
     for (auto Itr = ParamList.begin(); Itr != ParamList.end(); ++Itr) {
       dbgs() << (*Itr)->getName();
       if (std::next(Itr) != ParamList.end())
         dbgs() << ", ";
     }
     dbgs() << ")\n";
+    if (!Func.hasPostfix()) {
+      dbgs() << "Postfix: not generated yet\n\n";
+      continue;
+    }
     dbgs() << "Postfix:\n";
     std::size_t LineN = 0;
-    auto &PL = Pair.second.getPostfixList();
+    auto &PL = Func.getPostfixList();
     auto MaxNumLength = std::to_string(PL.size()).size();
     for (const auto &PostfixLine : PL) {
       auto NumLength = std::to_string(LineN).size();
@@ -1,120 +1,257 @@
 #include "dragon/analysis/Token.h"
 
-const std::string Keyword::mPunctuations = "+,-*/%^|&!()[]:<>=\"";
-
-const Bimap<Keyword::Kind, std::string> Keyword::mKindToName = {
-  KEYPAIR(Keyword::FUNCTION, "function"),
-  KEYPAIR(Keyword::RETURN, "return"),
-  KEYPAIR(Keyword::PRINTLN, "println"),
-  KEYPAIR(Keyword::PRINT, "print"),
-  KEYPAIR(Keyword::IF, "if"),
-  KEYPAIR(Keyword::ELSE, "else"),
-  KEYPAIR(Keyword::ENDIF, "endif"),
-  KEYPAIR(Keyword::WHILE, "while"),
-  KEYPAIR(Keyword::ENDWHILE, "endwhile"),
-  KEYPAIR(Keyword::COMMA, ","),
-  KEYPAIR(Keyword::ASSIGN, "="),
-  KEYPAIR(Keyword::LOGICAL_OR, "or"),
-  KEYPAIR(Keyword::LOGICAL_AND, "and"),
-  KEYPAIR(Keyword::LOGICAL_NOT, "!"),
-  KEYPAIR(Keyword::BITWISE_OR, "|"),
-  KEYPAIR(Keyword::BITWISE_AND, "&"),
-  KEYPAIR(Keyword::BITWISE_XOR, "^"),
-  KEYPAIR(Keyword::EQUAL, "=="),
-  KEYPAIR(Keyword::NOT_EQUAL, "!="),
-  KEYPAIR(Keyword::LESS, "<"),
-  KEYPAIR(Keyword::LEQ, "<="),
-  KEYPAIR(Keyword::GREATER, ">"),
-  KEYPAIR(Keyword::GEQ, ">="),
-  KEYPAIR(Keyword::SHL, "<<"),
-  KEYPAIR(Keyword::SHR, ">>"),
-  KEYPAIR(Keyword::PLUS, "+"),
-  KEYPAIR(Keyword::MINUS, "-"),
-  KEYPAIR(Keyword::MULTIPLY, "*"),
-  KEYPAIR(Keyword::DIVIDE, "/"),
-  KEYPAIR(Keyword::MODULE, "%"),
-  KEYPAIR(Keyword::LEFT_PARENTHESIS, "("),
-  KEYPAIR(Keyword::RIGHT_PARENTHESIS, ")"),
-  KEYPAIR(Keyword::QUOTE, "\""),
-  KEYPAIR(Keyword::GOTO_BIN, "goto"),
-  KEYPAIR(Keyword::GOTO_UN, "goto*"),
-  KEYPAIR(Keyword::UNARY_MINUS, "-$"),
-  KEYPAIR(Keyword::UNARY_PLUS, "+$"),
-  KEYPAIR(Keyword::GLOBAL, "global")
+namespace {
+
+struct KeywordInfo {
+  Keyword::Kind Kind;
+  std::string_view Name;
+  Keyword::Priority Priority;
+  bool Forbidden = false;
 };
 
-const std::map<Keyword::Kind, Keyword::Priority> Keyword::mKindToPriority = {
-  KEYPAIR(Keyword::FUNCTION, -1),
-  KEYPAIR(Keyword::RETURN, 100),
-  KEYPAIR(Keyword::PRINTLN, 100),
-  KEYPAIR(Keyword::PRINT, 100),
-  KEYPAIR(Keyword::IF, 99),
-  KEYPAIR(Keyword::ELSE, -1),
-  KEYPAIR(Keyword::ENDIF, -1),
-  KEYPAIR(Keyword::WHILE, 99),
-  KEYPAIR(Keyword::ENDWHILE, -1),
-  KEYPAIR(Keyword::QUOTE, -1),
-  KEYPAIR(Keyword::GOTO_BIN, 101),
-  KEYPAIR(Keyword::GOTO_UN, 101),
-  KEYPAIR(Keyword::GLOBAL, 100),
+// The single source of keyword metadata. Names, priorities, the word hash
+// and the operator matcher below are all derived from it at compile time.
+constexpr KeywordInfo KeywordTable[] = {
+  { Keyword::FUNCTION, "function", -1 },
+  { Keyword::RETURN, "return", 100 },
+  { Keyword::PRINTLN, "println", 100 },
+  { Keyword::PRINT, "print", 100 },
+  { Keyword::IF, "if", 99 },
+  { Keyword::ELSE, "else", -1 },
+  { Keyword::ENDIF, "endif", -1 },
+  { Keyword::WHILE, "while", 99 },
+  { Keyword::ENDWHILE, "endwhile", -1 },
+  { Keyword::FOR, "for", 99 },
+  { Keyword::ENDFOR, "endfor", -1 },
+  { Keyword::QUOTE, "\"", -1 },
+  { Keyword::GOTO_BIN, "goto", 101, true },
+  { Keyword::GOTO_UN, "goto*", 101, true },
+  { Keyword::GLOBAL, "global", 100 },
+  { Keyword::DELETE, "delete", 100 },
+  { Keyword::FOR_NEXT, "for*", 101, true },
+  { Keyword::INDEX, "[]", 101, true },
+  { Keyword::SLICE, "[:]", 101, true },
+  { Keyword::MAKE_ARRAY, "[,]", 101, true },
 
-  KEYPAIR(Keyword::LEFT_PARENTHESIS, 1),
-  KEYPAIR(Keyword::RIGHT_PARENTHESIS, 1),
+  { Keyword::LEFT_PARENTHESIS, "(", 1 },
+  { Keyword::RIGHT_PARENTHESIS, ")", 1 },
+  { Keyword::LEFT_SQUARE_BRACKET, "[", 1 },
+  { Keyword::RIGHT_SQUARE_BRACKET, "]", 1 },
 
-  KEYPAIR(Keyword::UNARY_PLUS, 2),
-  KEYPAIR(Keyword::UNARY_MINUS, 2),
-  KEYPAIR(Keyword::LOGICAL_NOT, 2),
+  { Keyword::UNARY_PLUS, "+$", 2, true },
+  { Keyword::UNARY_MINUS, "-$", 2, true },
+  { Keyword::LOGICAL_NOT, "!", 2 },
+  { Keyword::LEN, "len", 2 },
 
-  KEYPAIR(Keyword::MULTIPLY, 3),
-  KEYPAIR(Keyword::DIVIDE, 3),
-  KEYPAIR(Keyword::MODULE, 3),
+  { Keyword::MULTIPLY, "*", 3 },
+  { Keyword::DIVIDE, "/", 3 },
+  { Keyword::MODULE, "%", 3 },
 
-  KEYPAIR(Keyword::PLUS, 4),
-  KEYPAIR(Keyword::MINUS, 4),
+  { Keyword::PLUS, "+", 4 },
+  { Keyword::MINUS, "-", 4 },
 
-  KEYPAIR(Keyword::SHL, 5),
-  KEYPAIR(Keyword::SHR, 5),
+  { Keyword::SHL, "<<", 5 },
+  { Keyword::SHR, ">>", 5 },
 
-  KEYPAIR(Keyword::LESS, 6),
-  KEYPAIR(Keyword::LEQ, 6),
-  KEYPAIR(Keyword::GREATER, 6),
-  KEYPAIR(Keyword::GEQ, 6),
+  { Keyword::LESS, "<", 6 },
+  { Keyword::LEQ, "<=", 6 },
+  { Keyword::GREATER, ">", 6 },
+  { Keyword::GEQ, ">=", 6 },
+  { Keyword::IN, "in", 6 },
 
-  KEYPAIR(Keyword::EQUAL, 7),
-  KEYPAIR(Keyword::NOT_EQUAL, 7),
+  { Keyword::EQUAL, "==", 7 },
+  { Keyword::NOT_EQUAL, "!=", 7 },
 
-  KEYPAIR(Keyword::BITWISE_AND, 8),
+  { Keyword::BITWISE_AND, "&", 8 },
 
-  KEYPAIR(Keyword::BITWISE_XOR, 9),
+  { Keyword::BITWISE_XOR, "^", 9 },
 
-  KEYPAIR(Keyword::BITWISE_OR, 10),
+  { Keyword::BITWISE_OR, "|", 10 },
 
-  KEYPAIR(Keyword::LOGICAL_AND, 11),
-  KEYPAIR(Keyword::LOGICAL_OR, 12),
-  
-  KEYPAIR(Keyword::ASSIGN, 13),
+  { Keyword::LOGICAL_AND, "and", 11 },
+  { Keyword::LOGICAL_OR, "or", 12 },
 
-  KEYPAIR(Keyword::COMMA, 15),
-};
+  { Keyword::ASSIGN, "=", 13 },
 
-const std::set<std::string> Keyword::mForbiddenKws = {
-  "goto", "goto*", "-$", "+$"
+  { Keyword::COMMA, ",", 15 },
+  { Keyword::COLON, ":", 15 },
 };
 
-void Keyword::addDynamicKeyword(const std::string &Word,
+constexpr bool isWordKeyword(const KeywordInfo &Info) {
+  return Info.Name[0] >= 'a' && Info.Name[0] <= 'z';
+}
+
+/* Perfect hash of alphabetic keywords */
+
+constexpr std::size_t WordTableSize = 64;
+
+constexpr std::size_t hashWord(std::string_view Word, unsigned Seed) {
+  return (static_cast<unsigned char>(Word.front()) * Seed +
+          static_cast<unsigned char>(Word.back()) + Word.size()) %
+         WordTableSize;
+}
+
+constexpr bool isPerfectSeed(unsigned Seed) {
+  std::array<bool, WordTableSize> Used {};
+  for (auto &Info : KeywordTable) {
+    if (!isWordKeyword(Info))
+      continue;
+    auto Hash = hashWord(Info.Name, Seed);
+    if (Used[Hash])
+      return false;
+    Used[Hash] = true;
+  }
+  return true;
+}
+
+constexpr unsigned findSeed() {
+  for (unsigned Seed = 1; Seed < 1024; ++Seed)
+    if (isPerfectSeed(Seed))
+      return Seed;
+  return 0;
+}
+
+constexpr unsigned WordSeed = findSeed();
+static_assert(WordSeed != 0, "No perfect hash for the keyword words, grow "
+              "the word table!");
+
+// Index of the keyword in KeywordTable plus one, 0 for empty buckets.
+constexpr auto makeWordTable() {
+  std::array<std::uint8_t, WordTableSize> Table {};
+  for (std::size_t I = 0; I < std::size(KeywordTable); ++I)
+    if (isWordKeyword(KeywordTable[I]))
+      Table[hashWord(KeywordTable[I].Name, WordSeed)] = I + 1;
+  return Table;
+}
+
+constexpr auto WordTable = makeWordTable();
+
+constexpr std::optional<Keyword::Kind> lookupWord(std::string_view Word) {
+  if (Word.empty())
+    return std::nullopt;
+  auto Idx = WordTable[hashWord(Word, WordSeed)];
+  if (!Idx || KeywordTable[Idx - 1].Name != Word)
+    return std::nullopt;
+  return KeywordTable[Idx - 1].Kind;
+}
+
+/* Operators */
+
+constexpr std::size_t matchPrefix(std::string_view Str, Keyword::Kind &K) {
+  auto match = [&K](Keyword::Kind Kind, std::size_t Len) {
+    K = Kind;
+    return Len;
+  };
+  if (Str.empty())
+    return 0;
+  char Next = Str.size() > 1 ? Str[1] : '\0';
+  switch (Str[0]) {
+  case '+': return match(Keyword::PLUS, 1);
+  case '-': return match(Keyword::MINUS, 1);
+  case '*': return match(Keyword::MULTIPLY, 1);
+  case '/': return match(Keyword::DIVIDE, 1);
+  case '%': return match(Keyword::MODULE, 1);
+  case '^': return match(Keyword::BITWISE_XOR, 1);
+  case '|': return match(Keyword::BITWISE_OR, 1);
+  case '&': return match(Keyword::BITWISE_AND, 1);
+  case ',': return match(Keyword::COMMA, 1);
+  case '(': return match(Keyword::LEFT_PARENTHESIS, 1);
+  case ')': return match(Keyword::RIGHT_PARENTHESIS, 1);
+  case '[': return match(Keyword::LEFT_SQUARE_BRACKET, 1);
+  case ']': return match(Keyword::RIGHT_SQUARE_BRACKET, 1);
+  case ':': return match(Keyword::COLON, 1);
+  case '"': return match(Keyword::QUOTE, 1);
+  case '!':
+    return Next == '=' ? match(Keyword::NOT_EQUAL, 2) :
+                         match(Keyword::LOGICAL_NOT, 1);
+  case '=':
+    return Next == '=' ? match(Keyword::EQUAL, 2) : match(Keyword::ASSIGN, 1);
+  case '<':
+    if (Next == '=')
+      return match(Keyword::LEQ, 2);
+    return Next == '<' ? match(Keyword::SHL, 2) : match(Keyword::LESS, 1);
+  case '>':
+    if (Next == '=')
+      return match(Keyword::GEQ, 2);
+    return Next == '>' ? match(Keyword::SHR, 2) : match(Keyword::GREATER, 1);
+  default:
+    return 0;
+  }
+}
+
+// The matcher is written by hand, check that it agrees with the table.
+constexpr bool checkOperators() {
+  for (auto &Info : KeywordTable) {
+    if (isWordKeyword(Info) || Info.Forbidden)
+      continue;
+    Keyword::Kind Kind = Keyword::FUNCTION;
+    if (matchPrefix(Info.Name, Kind) != Info.Name.size() ||
+        Kind != Info.Kind)
+      return false;
+  }
+  return true;
+}
+
+static_assert(checkOperators(), "Operator matcher is out of sync with the "
+              "keyword table!");
+
+template <typename T, typename Getter>
+constexpr auto makeKindTable(T Default, Getter Get) {
+  std::array<T, Keyword::BINARY_END + 1> Table {};
+  for (auto &Elem : Table)
+    Elem = Default;
+  for (auto &Info : KeywordTable)
+    Table[Info.Kind] = Get(Info);
+  return Table;
+}
+
+constexpr auto makePunctChars() {
+  std::array<bool, 256> Table {};
+  for (char Char : Keyword::getPunctStr())
+    Table[static_cast<unsigned char>(Char)] = true;
+  return Table;
+}
+
+} // namespace
+
+const std::array<std::string_view, Keyword::KindCount> Keyword::mNames =
+    makeKindTable(std::string_view(), [](const KeywordInfo &Info) {
+      return Info.Name;
+    });
+
+const std::array<Keyword::Priority, Keyword::KindCount> Keyword::mPriorities =
+    makeKindTable(NoPriority, [](const KeywordInfo &Info) {
+      return Info.Priority;
+    });
+
+const std::array<bool, Keyword::KindCount> Keyword::mForbidden =
+    makeKindTable(false, [](const KeywordInfo &Info) {
+      return Info.Forbidden;
+    });
+
+const std::array<bool, 256> Keyword::mPunctChars = makePunctChars();
+
+std::optional<Keyword::Kind> Keyword::getWordKind(std::string_view Word) {
+  return lookupWord(Word);
+}
+
+std::size_t Keyword::matchOperator(std::string_view Str, Kind &K) {
+  return matchPrefix(Str, K);
+}
+
+void Keyword::addDynamicKeyword(Kind K,
                                 std::vector<std::unique_ptr<Token>> &TL,
                                 const PosInfo &PI) {
-  auto Kw = Keyword(Word, PI);
-  if (Kw.mKind >= Kind::BINARY_BEGIN && Kw.mKind <= Kind::BINARY_END) {
-    TL.push_back(std::make_unique<BinaryOperator>(Kw.mKind, PI,
-        Kw.mKind == Kind::ASSIGN ?
+  if (K >= Kind::BINARY_BEGIN && K <= Kind::BINARY_END) {
+    TL.push_back(std::make_unique<BinaryOperator>(K, PI,
+        K == Kind::ASSIGN ?
             BinaryOperator::AssocKind::RIGHT :
             BinaryOperator::AssocKind::LEFT));
-  } else if (Kw.mKind >= BRACKETS_BEGIN && Kw.mKind <= BRACKETS_END) {
-    TL.push_back(std::make_unique<Bracket>(Kw.mKind, PI));
-  } else if (Kw.mKind >= UNARY_BEGIN && Kw.mKind <= UNARY_END) {
-    TL.push_back(std::make_unique<PrefixOperator>(Kw.mKind, PI));
+  } else if (K >= BRACKETS_BEGIN && K <= BRACKETS_END) {
+    TL.push_back(std::make_unique<Bracket>(K, PI));
+  } else if (K >= UNARY_BEGIN && K <= UNARY_END) {
+    TL.push_back(std::make_unique<PrefixOperator>(K, PI));
   } else {
-    TL.push_back(std::make_unique<Keyword>(Word, PI));
+    TL.push_back(std::make_unique<Keyword>(K, PI));
   }
 }
\ No newline at end of file
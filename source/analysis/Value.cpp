@@ -0,0 +1,51 @@
+#include "dragon/analysis/Value.h"
+#include "dragon/analysis/Dict.h"
+
+std::string Value::toString() const {
+  switch (mType) {
+  case NIL:
+    return "<nil>";
+  case INTEGER:
+    return "<int: " + std::to_string(getInt()) + ">";
+  case FLOAT:
+    return "<float: " + std::to_string(getFloat()) + ">";
+  case BOOLEAN:
+    return "<bool: " + std::string(getBool() ? "true" : "false") + ">";
+  case STRING:
+    return "<literal: " + (getString().empty() ? std::string("(empty)") :
+                           std::string(getString())) + ">";
+  case BIGINT:
+    return "<int: " + getBigInt().toString() + ">";
+  case ARRAY:
+    return "<array of " + std::string(typeToString(getElementType())) + ": " +
+           std::to_string(getArrayLength()) + ">";
+  case DICT:
+    return "<dict: " + std::to_string(getDict().size()) + ">";
+  }
+  return "<unknown value>";
+}
+
+void StringObject::destroy(const StringObject *Obj) {
+  if (Obj->holdsDict())
+    reinterpret_cast<const Dict *>(Obj->getData())->~Dict();
+  delete[] reinterpret_cast<const char *>(Obj);
+}
+
+BigInt Value::getBigInt() const {
+  assert(isBigInt());
+  return BigInt::readBytes(getObjectView());
+}
+
+const char *Value::typeToString(Type T) {
+  switch (T) {
+  case NIL: return "nil";
+  case INTEGER: return "int";
+  case FLOAT: return "float";
+  case BOOLEAN: return "bool";
+  case STRING: return "string";
+  case BIGINT: return "int";
+  case ARRAY: return "array";
+  case DICT: return "dict";
+  }
+  return "<unknown type>";
+}
\ No newline at end of file